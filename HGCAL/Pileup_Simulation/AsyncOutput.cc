@@ -0,0 +1,428 @@
+#include "AsyncOutput.hh"
+#include "HexCellGeometry.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include "tools/wroot/file"
+#include "tools/wroot/ntuple"
+#if __has_include("toolx/zlib")
+#include "toolx/zlib"
+#define ASYNC_COMPRESS_BUFFER toolx::compress_buffer
+#else
+#include "tools/zlib"
+#define ASYNC_COMPRESS_BUFFER tools::compress_buffer
+#endif
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    std::uint64_t NowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::size_t RoundUpPowerOfTwo(std::size_t n) {
+        std::size_t capacity = 1;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+}
+
+// ------------------------------------------------------------
+// BatchQueue
+// ------------------------------------------------------------
+
+BatchQueue::BatchQueue(std::size_t capacity)
+: fSlots(new Slot[RoundUpPowerOfTwo(capacity)]),
+  fMask(RoundUpPowerOfTwo(capacity) - 1), fHead(0), fTail(0)
+{
+    for (std::size_t i = 0; i <= fMask; ++i) {
+        fSlots[i].sequence.store(i, std::memory_order_relaxed);
+        fSlots[i].batch = nullptr;
+    }
+}
+
+G4bool BatchQueue::TryPush(EventBatch* batch)
+{
+    std::size_t pos = fHead.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = fSlots[pos & fMask];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (fHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.batch = batch;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = fHead.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+G4bool BatchQueue::TryPop(EventBatch*& batch)
+{
+    // Single consumer: the writer thread
+    std::size_t pos = fTail.load(std::memory_order_relaxed);
+    Slot& slot = fSlots[pos & fMask];
+    std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1) < 0) {
+        return false;  // empty
+    }
+    batch = slot.batch;
+    slot.sequence.store(pos + fMask + 1, std::memory_order_release);
+    fTail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+std::size_t BatchQueue::Size() const
+{
+    std::size_t head = fHead.load(std::memory_order_relaxed);
+    std::size_t tail = fTail.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+}
+
+// ------------------------------------------------------------
+// Writer: ROOT file and ntuples, used only on the writer thread
+// ------------------------------------------------------------
+
+class AsyncOutput::Writer {
+public:
+    explicit Writer(const G4String& fileName)
+    : fFile(std::cout, fileName)
+    {
+        fFile.add_ziper('Z', ASYNC_COMPRESS_BUFFER);
+        fFile.set_compression(1);
+
+        // Same layouts as the ntuples booked in MyRunAction
+        fTracks = new tools::wroot::ntuple(fFile.dir(), "ParticleTracking", "Particle Tracking Data");
+        const char* trackIntNames[] = {"eventID", "track_id", "layer"};
+        for (const char* name : trackIntNames) fTrackInt.push_back(fTracks->create_column<int>(name));
+        const char* trackDoubleNames[] = {
+            "energy_before_MeV", "energy_after_MeV", "energy_deposited_MeV",
+            "px_before_MeV", "py_before_MeV", "pz_before_MeV",
+            "px_after_MeV", "py_after_MeV", "pz_after_MeV",
+            "x_enter_mm", "y_enter_mm", "z_enter_mm",
+            "x_exit_mm", "y_exit_mm", "z_exit_mm",
+            "r_enter_mm", "r_exit_mm"};
+        for (const char* name : trackDoubleNames) fTrackDouble.push_back(fTracks->create_column<double>(name));
+        fParticleID = fTracks->create_column<int>("particle_id");
+        fCumTr = fTracks->create_column<int>("cumTr");
+        fCharge = fTracks->create_column<double>("charge");
+        fEtaEnter = fTracks->create_column<double>("eta_enter");
+        fPhiEnter = fTracks->create_column<double>("phi_enter");
+        fEtaExit = fTracks->create_column<double>("eta_exit");
+        fPhiExit = fTracks->create_column<double>("phi_exit");
+        fTrackDetId = fTracks->create_column<int>("detid");
+
+        fCells = new tools::wroot::ntuple(fFile.dir(), "CellHits", "Hexagonal Cell-wise Hit Data");
+        fCellEvent = fCells->create_column<int>("event_id");
+        fCellDetId = fCells->create_column<int>("detid");
+        fCellEdep = fCells->create_column<float>("edep");
+        fCellTime = fCells->create_column<float>("time_ns");
+
+        fGeometry = new tools::wroot::ntuple(fFile.dir(), "CellGeometry", "Hexagonal Cell Geometry");
+        const char* geoIntNames[] = {"detid", "layer", "waferU", "waferV", "cellU", "cellV", "waferType"};
+        for (const char* name : geoIntNames) fGeoInt.push_back(fGeometry->create_column<int>(name));
+        const char* geoFloatNames[] = {"xi", "yi", "zi", "theta", "phi", "eta"};
+        for (const char* name : geoFloatNames) fGeoFloat.push_back(fGeometry->create_column<float>(name));
+
+        fBoundary = new tools::wroot::ntuple(fFile.dir(), "BoundaryTruth", "Particles Entering the Calorimeter");
+        const char* boundaryIntNames[] = {"event_id", "boundary_index", "track_id", "particle_id", "cumTr"};
+        for (const char* name : boundaryIntNames) fBoundaryInt.push_back(fBoundary->create_column<int>(name));
+        const char* boundaryFloatNames[] = {"energy_MeV", "px_MeV", "py_MeV", "pz_MeV", "x_mm", "y_mm", "z_mm", "time_ns"};
+        for (const char* name : boundaryFloatNames) fBoundaryFloat.push_back(fBoundary->create_column<float>(name));
+
+        fCellTruth = new tools::wroot::ntuple(fFile.dir(), "CellTruth", "Cell Energy Fractions by Boundary Particle");
+        fTruthEvent = fCellTruth->create_column<int>("event_id");
+        fTruthDetId = fCellTruth->create_column<int>("detid");
+        fTruthIndex = fCellTruth->create_column<int>("boundary_index");
+        fTruthFraction = fCellTruth->create_column<float>("fraction");
+    }
+
+    // Ntuples are owned by the file directory
+    ~Writer() {
+        unsigned int nbytes = 0;
+        fFile.write(nbytes);
+        fFile.close();
+    }
+
+    G4bool IsOpen() const { return fFile.is_open(); }
+
+    void Write(const EventBatch& batch) {
+        for (const MyHit& hit : batch.trackHits) WriteTrackHit(batch.eventID, hit);
+        for (const MyCellHit& hit : batch.cellHits) {
+            fCellEvent->fill(batch.eventID);
+            fCellDetId->fill(static_cast<int>(hit.detId));
+            fCellEdep->fill(static_cast<float>(hit.edep / MeV));
+            fCellTime->fill(static_cast<float>(hit.time / ns));
+            fCells->add_row();
+        }
+        for (const MyCellHit& hit : batch.newCells) WriteCellGeometry(hit);
+        for (std::size_t i = 0; i < batch.boundaryParticles.size(); ++i) {
+            WriteBoundaryParticle(batch.eventID, static_cast<G4int>(i), batch.boundaryParticles[i]);
+        }
+        for (const MyCellTruthHit& hit : batch.cellTruth) {
+            fTruthEvent->fill(batch.eventID);
+            fTruthDetId->fill(static_cast<int>(hit.detId));
+            fTruthIndex->fill(hit.boundaryIndex);
+            fTruthFraction->fill(static_cast<float>(hit.fraction));
+            fCellTruth->add_row();
+        }
+    }
+
+private:
+    tools::wroot::file fFile;
+
+    tools::wroot::ntuple* fTracks;
+    std::vector<tools::wroot::ntuple::column<int>*> fTrackInt;
+    std::vector<tools::wroot::ntuple::column<double>*> fTrackDouble;
+    tools::wroot::ntuple::column<int>* fParticleID;
+    tools::wroot::ntuple::column<int>* fCumTr;
+    tools::wroot::ntuple::column<double>* fCharge;
+    tools::wroot::ntuple::column<double>* fEtaEnter;
+    tools::wroot::ntuple::column<double>* fPhiEnter;
+    tools::wroot::ntuple::column<double>* fEtaExit;
+    tools::wroot::ntuple::column<double>* fPhiExit;
+    tools::wroot::ntuple::column<int>* fTrackDetId;
+
+    tools::wroot::ntuple* fCells;
+    tools::wroot::ntuple::column<int>* fCellEvent;
+    tools::wroot::ntuple::column<int>* fCellDetId;
+    tools::wroot::ntuple::column<float>* fCellEdep;
+    tools::wroot::ntuple::column<float>* fCellTime;
+
+    tools::wroot::ntuple* fGeometry;
+    std::vector<tools::wroot::ntuple::column<int>*> fGeoInt;
+    std::vector<tools::wroot::ntuple::column<float>*> fGeoFloat;
+
+    tools::wroot::ntuple* fBoundary;
+    std::vector<tools::wroot::ntuple::column<int>*> fBoundaryInt;
+    std::vector<tools::wroot::ntuple::column<float>*> fBoundaryFloat;
+
+    tools::wroot::ntuple* fCellTruth;
+    tools::wroot::ntuple::column<int>* fTruthEvent;
+    tools::wroot::ntuple::column<int>* fTruthDetId;
+    tools::wroot::ntuple::column<int>* fTruthIndex;
+    tools::wroot::ntuple::column<float>* fTruthFraction;
+
+    void WriteTrackHit(G4int eventID, const MyHit& data) {
+        G4double rEnter = std::sqrt(data.positionEnter.x() * data.positionEnter.x() +
+                                    data.positionEnter.y() * data.positionEnter.y());
+        G4double rExit = std::sqrt(data.positionExit.x() * data.positionExit.x() +
+                                   data.positionExit.y() * data.positionExit.y());
+        const G4double values[] = {
+            data.energyBefore / MeV, data.energyAfter / MeV, data.totalEnergyDeposited / MeV,
+            data.momentumBefore.x() / MeV, data.momentumBefore.y() / MeV, data.momentumBefore.z() / MeV,
+            data.momentumAfter.x() / MeV, data.momentumAfter.y() / MeV, data.momentumAfter.z() / MeV,
+            data.positionEnter.x() / mm, data.positionEnter.y() / mm, data.positionEnter.z() / mm,
+            data.positionExit.x() / mm, data.positionExit.y() / mm, data.positionExit.z() / mm,
+            rEnter / mm, rExit / mm};
+
+        fTrackInt[0]->fill(eventID);
+        fTrackInt[1]->fill(data.trackID);
+        fTrackInt[2]->fill(data.layer);
+        for (std::size_t i = 0; i < fTrackDouble.size(); ++i) fTrackDouble[i]->fill(values[i]);
+        fParticleID->fill(data.particleID);
+        fCumTr->fill(data.cumTr);
+        fCharge->fill(data.charge);
+        fEtaEnter->fill(data.etaEnter);
+        fPhiEnter->fill(data.phiEnter);
+        fEtaExit->fill(data.etaExit);
+        fPhiExit->fill(data.phiExit);
+        HexCell entryCell = HexCellGeometry::Locate(data.positionEnter.x(), data.positionEnter.y());
+        fTrackDetId->fill(static_cast<int>(HexCellGeometry::PackDetId(data.layer, entryCell)));
+        fTracks->add_row();
+    }
+
+    void WriteCellGeometry(const MyCellHit& data) {
+        G4int layer;
+        HexCell cell;
+        HexCellGeometry::UnpackDetId(data.detId, layer, cell);
+
+        G4double xi, yi;
+        HexCellGeometry::CellCenter(cell, xi, yi);
+        G4ThreeVector center(xi, yi, data.z);
+        G4double theta = center.theta();
+        G4double phiDeg = center.phi() / deg;  // [-180, 180], as in event.cc
+        G4double eta = (theta > 0 && theta < CLHEP::pi) ? -std::log(std::tan(theta / 2.0)) : 0.0;
+
+        const int ints[] = {static_cast<int>(data.detId), layer, cell.waferU, cell.waferV,
+                            cell.cellU, cell.cellV, cell.highDensity ? 0 : 1};
+        const float floats[] = {static_cast<float>(xi / mm), static_cast<float>(yi / mm),
+                                static_cast<float>(data.z / mm), static_cast<float>(theta / deg),
+                                static_cast<float>(phiDeg), static_cast<float>(eta)};
+        for (std::size_t i = 0; i < fGeoInt.size(); ++i) fGeoInt[i]->fill(ints[i]);
+        for (std::size_t i = 0; i < fGeoFloat.size(); ++i) fGeoFloat[i]->fill(floats[i]);
+        fGeometry->add_row();
+    }
+
+    void WriteBoundaryParticle(G4int eventID, G4int index, const BoundaryParticle& particle) {
+        const int ints[] = {eventID, index, particle.trackID, particle.particleID, particle.cumTr};
+        const float floats[] = {static_cast<float>(particle.energy / MeV),
+                                static_cast<float>(particle.momentum.x() / MeV),
+                                static_cast<float>(particle.momentum.y() / MeV),
+                                static_cast<float>(particle.momentum.z() / MeV),
+                                static_cast<float>(particle.position.x() / mm),
+                                static_cast<float>(particle.position.y() / mm),
+                                static_cast<float>(particle.position.z() / mm),
+                                static_cast<float>(particle.time / ns)};
+        for (std::size_t i = 0; i < fBoundaryInt.size(); ++i) fBoundaryInt[i]->fill(ints[i]);
+        for (std::size_t i = 0; i < fBoundaryFloat.size(); ++i) fBoundaryFloat[i]->fill(floats[i]);
+        fBoundary->add_row();
+    }
+};
+
+// ------------------------------------------------------------
+// AsyncOutput
+// ------------------------------------------------------------
+
+std::atomic<G4bool> AsyncOutput::fEnabled{false};
+std::atomic<G4int> AsyncOutput::fBuffersPerThread{2};
+
+AsyncOutput& AsyncOutput::Instance()
+{
+    static AsyncOutput instance;
+    return instance;
+}
+
+AsyncOutput::AsyncOutput()
+: fOpen(false), fStopping(false),
+  fSubmitted(0), fBufferWaits(0), fStallNanoseconds(0),
+  fHighWater(0), fWriteNanoseconds(0), fOpenNanoseconds(0)
+{}
+
+AsyncOutput::~AsyncOutput()
+{
+    Close();
+}
+
+G4bool AsyncOutput::Open(const G4String& fileName, G4int nThreads)
+{
+    if (IsOpen()) Close();
+
+    fWriter.reset(new Writer(fileName));
+    if (!fWriter->IsOpen()) {
+        G4cout << "ERROR: AsyncOutput: cannot open " << fileName << G4endl;
+        fWriter.reset();
+        return false;
+    }
+
+    // Every buffer of every worker fits, so a submit never finds it full
+    fQueue.reset(new BatchQueue(static_cast<std::size_t>(std::max(nThreads, 1)) * GetBuffersPerThread()));
+    fSubmitted = 0;
+    fBufferWaits = 0;
+    fStallNanoseconds = 0;
+    fHighWater = 0;
+    fWriteNanoseconds = 0;
+    fOpenNanoseconds = NowNanoseconds();
+
+    fStopping.store(false, std::memory_order_relaxed);
+    fThread = std::thread(&AsyncOutput::WriterLoop, this);
+    fOpen.store(true, std::memory_order_release);
+
+    G4cout << "AsyncOutput: writing hits to " << fileName << " on a writer thread" << G4endl;
+    return true;
+}
+
+void AsyncOutput::Close()
+{
+    if (!IsOpen()) return;
+
+    // All workers have finished the run: drain the queue and stop
+    fOpen.store(false, std::memory_order_release);
+    fStopping.store(true, std::memory_order_release);
+    fThread.join();
+    fWriter.reset();
+
+    G4double elapsedMs = (NowNanoseconds() - fOpenNanoseconds) * 1e-6;
+    G4cout << "AsyncOutput: " << fSubmitted.load() << " events written"
+           << " | queue high-water " << fHighWater.load() << "/" << fQueue->Capacity()
+           << " | buffer waits " << fBufferWaits.load()
+           << " | producer stall " << fStallNanoseconds.load() * 1e-6 << " ms"
+           << " | writer busy " << fWriteNanoseconds * 1e-6 << " of " << elapsedMs << " ms" << G4endl;
+    if (fBufferWaits.load() > 0) {
+        G4cout << "AsyncOutput: WARNING: tracking waited for the writer, output is the bottleneck" << G4endl;
+    }
+}
+
+void AsyncOutput::Submit(EventBatch* batch)
+{
+    // Only fails if a producer has more buffers than the queue was sized for
+    while (!fQueue->TryPush(batch)) {
+        std::this_thread::yield();
+    }
+    fSubmitted.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t size = fQueue->Size();
+    std::size_t highWater = fHighWater.load(std::memory_order_relaxed);
+    while (size > highWater &&
+           !fHighWater.compare_exchange_weak(highWater, size, std::memory_order_relaxed)) {}
+}
+
+void AsyncOutput::AddBufferWait(std::uint64_t nanoseconds)
+{
+    fBufferWaits.fetch_add(1, std::memory_order_relaxed);
+    fStallNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void AsyncOutput::WriterLoop()
+{
+    EventBatch* batch = nullptr;
+    for (;;) {
+        if (fQueue->TryPop(batch)) {
+            std::uint64_t start = NowNanoseconds();
+            fWriter->Write(*batch);
+            fWriteNanoseconds += NowNanoseconds() - start;
+            batch->busy.store(false, std::memory_order_release);
+            continue;
+        }
+        if (fStopping.load(std::memory_order_acquire)) {
+            if (fQueue->Size() == 0) break;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// ------------------------------------------------------------
+// AsyncOutputProducer
+// ------------------------------------------------------------
+
+AsyncOutputProducer::AsyncOutputProducer(G4int nBuffers)
+: fBuffers(new EventBatch[std::max(nBuffers, 1)]), fNumberOfBuffers(std::max(nBuffers, 1)), fCurrent(0)
+{}
+
+AsyncOutputProducer::~AsyncOutputProducer()
+{
+    for (G4int i = 0; i < fNumberOfBuffers; ++i) {
+        while (fBuffers[i].busy.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+EventBatch& AsyncOutputProducer::Acquire()
+{
+    EventBatch& buffer = fBuffers[fCurrent];
+    if (buffer.busy.load(std::memory_order_acquire)) {
+        std::uint64_t start = NowNanoseconds();
+        while (buffer.busy.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        AsyncOutput::Instance().AddBufferWait(NowNanoseconds() - start);
+    }
+    buffer.Clear();
+    return buffer;
+}
+
+void AsyncOutputProducer::Submit()
+{
+    EventBatch& buffer = fBuffers[fCurrent];
+    buffer.busy.store(true, std::memory_order_relaxed);
+    AsyncOutput::Instance().Submit(&buffer);
+    fCurrent = (fCurrent + 1) % fNumberOfBuffers;
+}
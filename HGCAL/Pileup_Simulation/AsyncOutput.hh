@@ -0,0 +1,129 @@
+#ifndef ASYNCOUTPUT_HH
+#define ASYNCOUTPUT_HH
+
+#include "globals.hh"
+#include "hit.hh"
+#include "BoundaryTruth.hh"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Hits of one event, handed from a worker to the writer thread
+struct EventBatch {
+    G4int eventID = 0;
+    std::vector<MyHit> trackHits;
+    std::vector<MyCellHit> cellHits;
+    std::vector<MyCellHit> newCells;      // first appearance in this file (CellGeometry)
+    std::vector<BoundaryParticle> boundaryParticles;
+    std::vector<MyCellTruthHit> cellTruth;
+    std::atomic<G4bool> busy{false};      // owned by the writer until written
+
+    void Clear() {
+        trackHits.clear();
+        cellHits.clear();
+        newCells.clear();
+        boundaryParticles.clear();
+        cellTruth.clear();
+    }
+};
+
+// Bounded lock-free multi-producer queue of batch pointers
+// (sequence-numbered ring buffer; capacity is a power of two)
+class BatchQueue {
+public:
+    explicit BatchQueue(std::size_t capacity);
+
+    G4bool TryPush(EventBatch* batch);
+    G4bool TryPop(EventBatch*& batch);
+    std::size_t Size() const;
+    std::size_t Capacity() const { return fMask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        EventBatch* batch;
+    };
+    std::unique_ptr<Slot[]> fSlots;
+    std::size_t fMask;
+    alignas(64) std::atomic<std::size_t> fHead;  // next slot to push
+    alignas(64) std::atomic<std::size_t> fTail;  // next slot to pop
+};
+
+// Dedicated writer thread for the ParticleTracking, CellHits and CellGeometry
+// ntuples (and BoundaryTruth, CellTruth). Workers submit complete events and go on tracking; serialization
+// and compression happen on the writer thread, into a separate ROOT file.
+// Opened and closed by the master run action.
+class AsyncOutput {
+public:
+    static AsyncOutput& Instance();
+
+    static void SetEnabled(G4bool enable) { fEnabled = enable; }
+    static G4bool IsEnabled() { return fEnabled; }
+
+    // Buffers per worker (/hgcal/output/asyncBuffers): how many events a
+    // worker can have in flight before it waits for the writer
+    static void SetBuffersPerThread(G4int nBuffers) { fBuffersPerThread = std::max(nBuffers, 1); }
+    static G4int GetBuffersPerThread() { return fBuffersPerThread; }
+
+    // The queue is sized to hold every buffer of nThreads workers at once
+    G4bool Open(const G4String& fileName, G4int nThreads);
+    void Close();
+    G4bool IsOpen() const { return fOpen.load(std::memory_order_acquire); }
+
+    // Never waits: a batch is only submitted from a buffer, and the queue
+    // holds all of them
+    void Submit(EventBatch* batch);
+
+    // Time a producer spent waiting for a free buffer
+    void AddBufferWait(std::uint64_t nanoseconds);
+
+private:
+    AsyncOutput();
+    ~AsyncOutput();
+
+    class Writer;
+
+    void WriterLoop();
+
+    static std::atomic<G4bool> fEnabled;
+    static std::atomic<G4int> fBuffersPerThread;
+
+    std::unique_ptr<BatchQueue> fQueue;
+    std::unique_ptr<Writer> fWriter;
+    std::thread fThread;
+    std::atomic<G4bool> fOpen;
+    std::atomic<G4bool> fStopping;
+
+    // Back-pressure metrics
+    std::atomic<std::uint64_t> fSubmitted;
+    std::atomic<std::uint64_t> fBufferWaits;
+    std::atomic<std::uint64_t> fStallNanoseconds;
+    std::atomic<std::size_t> fHighWater;
+    std::uint64_t fWriteNanoseconds;   // writer thread only
+    std::uint64_t fOpenNanoseconds;    // steady-clock time of Open
+};
+
+// Per-worker ring of buffers: one batch is filled while the others are
+// queued or being written
+class AsyncOutputProducer {
+public:
+    explicit AsyncOutputProducer(G4int nBuffers);
+    ~AsyncOutputProducer();
+
+    // Free buffer for the next event (waits if the writer still holds it)
+    EventBatch& Acquire();
+    // Hand the buffer returned by Acquire to the writer
+    void Submit();
+
+    G4int GetNumberOfBuffers() const { return fNumberOfBuffers; }
+
+private:
+    std::unique_ptr<EventBatch[]> fBuffers;
+    G4int fNumberOfBuffers;
+    G4int fCurrent;
+};
+
+#endif
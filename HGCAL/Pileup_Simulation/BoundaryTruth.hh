@@ -0,0 +1,49 @@
+#ifndef BOUNDARYTRUTH_HH
+#define BOUNDARYTRUTH_HH
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include <atomic>
+#include <vector>
+
+class G4Track;
+class G4StepPoint;
+
+// Particle entering the calorimeter, at the boundary (BoundaryTruth ntuple)
+struct BoundaryParticle {
+    G4int trackID;
+    G4int particleID;
+    G4int cumTr;
+    G4double energy;         // kinetic
+    G4ThreeVector momentum;
+    G4ThreeVector position;
+    G4double time;           // global
+};
+
+// Boundary truth, in the spirit of CMS CaloParticles (/hgcal/output/boundaryTruth).
+// A particle that steps from the world into the calorimeter (a layer or its
+// envelope), with no ancestor that did so before, gets the next index of the
+// event. Its secondaries inherit the index through TrackInformation, and the
+// sensitive detector splits the energy of each cell by index (CellTruth).
+// One recorder per worker thread, cleared at the start of each event.
+class BoundaryTruth {
+public:
+    static BoundaryTruth& Instance();
+
+    static void SetEnabled(G4bool enable) { fEnabled = enable; }
+    static G4bool IsEnabled() { return fEnabled; }
+
+    void Clear() { fParticles.clear(); }
+    // Records the track at the given point and returns its index
+    G4int Add(const G4Track* track, const G4StepPoint* point);
+    const std::vector<BoundaryParticle>& GetParticles() const { return fParticles; }
+
+private:
+    BoundaryTruth() = default;
+
+    static std::atomic<G4bool> fEnabled;
+
+    std::vector<BoundaryParticle> fParticles;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "HelixPropagator.hh"
+#include "CLHEP/Units/PhysicalConstants.h"
+#include <cfloat>
+#include <cmath>
+
+G4bool HelixPropagator::PropagateToPlane(const G4ThreeVector& momentum, G4double charge, G4double mass,
+                                         G4double fieldZ, G4double zPlane, HelixState& state)
+{
+    const G4double pz = momentum.z();
+    if (pz <= 0.) return false;
+
+    const G4double pT = momentum.perp();
+    const G4double phi0 = momentum.phi();
+    const G4double k = -charge * fieldZ * CLHEP::c_light;
+
+    G4double x, y, psi;
+    if (std::fabs(k * zPlane) < 1e-9 * std::fabs(pz)) {
+        // Neutral or negligible bending: straight line
+        psi = phi0;
+        x = momentum.x() / pz * zPlane;
+        y = momentum.y() / pz * zPlane;
+    } else {
+        psi = phi0 + k * zPlane / pz;
+        x = (pT / k) * (std::sin(psi) - std::sin(phi0));
+        y = -(pT / k) * (std::cos(psi) - std::cos(phi0));
+    }
+
+    // Helix length is proportional to z; t = L E / (p c)
+    const G4double p = momentum.mag();
+    const G4double energy = std::sqrt(p * p + mass * mass);
+
+    state.position = G4ThreeVector(x, y, zPlane);
+    state.momentum = G4ThreeVector(pT * std::cos(psi), pT * std::sin(psi), pz);
+    state.pathLength = zPlane * p / pz;
+    state.time = state.pathLength * energy / (p * CLHEP::c_light);
+    return true;
+}
+
+G4double HelixPropagator::MaxRadius(const G4ThreeVector& momentum, G4double charge, G4double fieldZ)
+{
+    const G4double k = std::fabs(charge * fieldZ * CLHEP::c_light);
+    if (k == 0.) return DBL_MAX;
+    return 2.0 * momentum.perp() / k;
+}
@@ -0,0 +1,29 @@
+#ifndef HELIXPROPAGATOR_HH
+#define HELIXPROPAGATOR_HH
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+// Position, momentum and time of a particle after analytic propagation
+struct HelixState {
+    G4ThreeVector position;
+    G4ThreeVector momentum;
+    G4double time;
+    G4double pathLength;
+};
+
+// Exact transport of a charged (or neutral) particle from the origin through
+// vacuum in a uniform field B along z. With k = -q B c the transverse phase
+// is psi(z) = phi0 + k z / pz, and
+//   x(z) = (pT / k) (sin psi - sin phi0),  y(z) = -(pT / k) (cos psi - cos phi0)
+class HelixPropagator {
+public:
+    // Propagate to the plane at zPlane; false if the particle never gets there (pz <= 0)
+    static G4bool PropagateToPlane(const G4ThreeVector& momentum, G4double charge, G4double mass,
+                                   G4double fieldZ, G4double zPlane, HelixState& state);
+
+    // Largest distance from the beam line the helix ever reaches (2R; infinite if straight)
+    static G4double MaxRadius(const G4ThreeVector& momentum, G4double charge, G4double fieldZ);
+};
+
+#endif
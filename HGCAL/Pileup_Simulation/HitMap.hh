@@ -0,0 +1,123 @@
+#ifndef HITMAP_HH
+#define HITMAP_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map (linear probing) from a packed 64-bit key to a
+// value. Storage is kept across Clear() calls, so once the table has grown
+// to the largest event seen, filling it allocates nothing.
+template <typename T>
+class FlatHitMap {
+public:
+    static constexpr std::uint64_t kEmptyKey = ~std::uint64_t(0);
+
+    explicit FlatHitMap(std::size_t initialCapacity = 1024) : fSize(0) {
+        std::size_t capacity = 16;
+        while (capacity < initialCapacity) capacity <<= 1;
+        fKeys.assign(capacity, kEmptyKey);
+        fValues.resize(capacity);
+    }
+
+    // Returns the value for 'key', inserting a default-constructed one if needed
+    T& FindOrInsert(std::uint64_t key, bool& inserted) {
+        if (2 * (fSize + 1) > fKeys.size()) Grow();
+        std::size_t i = Home(key);
+        while (fKeys[i] != kEmptyKey) {
+            if (fKeys[i] == key) {
+                inserted = false;
+                return fValues[i];
+            }
+            i = (i + 1) & Mask();
+        }
+        fKeys[i] = key;
+        fValues[i] = T();
+        ++fSize;
+        inserted = true;
+        return fValues[i];
+    }
+
+    T* Find(std::uint64_t key) {
+        std::size_t i = Home(key);
+        while (fKeys[i] != kEmptyKey) {
+            if (fKeys[i] == key) return &fValues[i];
+            i = (i + 1) & Mask();
+        }
+        return nullptr;
+    }
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    void Erase(std::uint64_t key) {
+        std::size_t i = Home(key);
+        while (fKeys[i] != key) {
+            if (fKeys[i] == kEmptyKey) return;
+            i = (i + 1) & Mask();
+        }
+        std::size_t j = i;
+        while (true) {
+            j = (j + 1) & Mask();
+            if (fKeys[j] == kEmptyKey) break;
+            std::size_t k = Home(fKeys[j]);
+            // Move entry j into the hole at i unless its home lies in (i, j]
+            bool inRange = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!inRange) {
+                fKeys[i] = fKeys[j];
+                fValues[i] = fValues[j];
+                i = j;
+            }
+        }
+        fKeys[i] = kEmptyKey;
+        --fSize;
+    }
+
+    // Visit every (key, value) pair; the map must not be modified meanwhile
+    template <typename F>
+    void ForEach(F&& f) {
+        for (std::size_t i = 0; i < fKeys.size(); ++i) {
+            if (fKeys[i] != kEmptyKey) f(fKeys[i], fValues[i]);
+        }
+    }
+
+    void Clear() {
+        if (fSize == 0) return;
+        std::fill(fKeys.begin(), fKeys.end(), kEmptyKey);
+        fSize = 0;
+    }
+
+    std::size_t Size() const { return fSize; }
+    bool Empty() const { return fSize == 0; }
+
+private:
+    std::vector<std::uint64_t> fKeys;
+    std::vector<T> fValues;
+    std::size_t fSize;
+
+    std::size_t Mask() const { return fKeys.size() - 1; }
+
+    std::size_t Home(std::uint64_t key) const {
+        // splitmix64 finalizer: spreads packed IDs over the whole table
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return static_cast<std::size_t>(key) & Mask();
+    }
+
+    void Grow() {
+        std::vector<std::uint64_t> oldKeys(fKeys.size() * 2, kEmptyKey);
+        std::vector<T> oldValues(fValues.size() * 2);
+        oldKeys.swap(fKeys);
+        oldValues.swap(fValues);
+        fSize = 0;
+        for (std::size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] == kEmptyKey) continue;
+            bool inserted;
+            FindOrInsert(oldKeys[i], inserted) = oldValues[i];
+        }
+    }
+};
+
+#endif
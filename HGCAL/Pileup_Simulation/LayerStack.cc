@@ -0,0 +1,338 @@
+#include "LayerStack.hh"
+#include "G4Material.hh"
+#include "G4NistManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    std::vector<std::string> SplitRow(const std::string& line) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            if (!field.empty() && field.back() == '\r') field.pop_back();
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    // Index of the first header field starting with prefix, -1 if none
+    int FindColumn(const std::vector<std::string>& header, const std::string& prefix) {
+        for (std::size_t i = 0; i < header.size(); ++i) {
+            if (header[i].compare(0, prefix.size(), prefix) == 0) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    G4bool ParseNumber(const std::vector<std::string>& fields, int column, G4double& value) {
+        if (column < 0 || column >= static_cast<int>(fields.size()) || fields[column].empty()) return false;
+        char* end = nullptr;
+        value = std::strtod(fields[column].c_str(), &end);
+        return end != fields[column].c_str();
+    }
+
+    std::string Lower(const std::string& text) {
+        std::string lower = text;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return lower;
+    }
+
+    // Volume name fragment: "Cooling plate (Cu)" -> "CoolingplateCu"
+    G4String CompactName(const std::string& text) {
+        G4String name;
+        for (char c : text) {
+            if (std::isalnum(static_cast<unsigned char>(c))) name += c;
+        }
+        return name;
+    }
+
+    struct RadiiRow {
+        G4double zMin;
+        G4double innerRadius;
+        G4double outerRadius;
+    };
+}
+
+G4Material* MaterialCache::Get(const G4String& name) {
+    auto it = fByName.find(name);
+    if (it != fByName.end()) return it->second;
+
+    // Defined by an earlier geometry, or a NIST material
+    G4Material* material = G4Material::GetMaterial(name, false);
+    G4NistManager* nist = G4NistManager::Instance();
+    if (!material && name.compare(0, 3, "G4_") == 0) {
+        material = nist->FindOrBuildMaterial(name);
+    }
+    if (!material && name == "StainlessSteel") {
+        material = new G4Material("StainlessSteel", 8.02*g/cm3, 2);
+        material->AddElement(nist->FindOrBuildElement("Fe"), 0.70);
+        material->AddElement(nist->FindOrBuildElement("Ni"), 0.30);
+    } else if (!material && name == "Kapton") {
+        material = new G4Material("Kapton", 1.11*g/cm3, 4);
+        material->AddElement(nist->FindOrBuildElement("C"), 5);
+        material->AddElement(nist->FindOrBuildElement("H"), 4);
+        material->AddElement(nist->FindOrBuildElement("O"), 2);
+        material->AddElement(nist->FindOrBuildElement("N"), 1);
+    } else if (!material && name == "PCB") {
+        material = new G4Material("PCB", 1.7*g/cm3, 3);
+        material->AddElement(nist->FindOrBuildElement("C"), 0.50);
+        material->AddElement(nist->FindOrBuildElement("H"), 0.30);
+        material->AddElement(nist->FindOrBuildElement("O"), 0.20);
+    } else if (!material && name == "Glue") {
+        material = new G4Material("Glue", 1.3*g/cm3, 3);
+        material->AddElement(nist->FindOrBuildElement("C"), 0.60);
+        material->AddElement(nist->FindOrBuildElement("H"), 0.30);
+        material->AddElement(nist->FindOrBuildElement("O"), 0.10);
+    }
+    if (!material) {
+        G4cout << "ERROR: Unknown material: " << name << G4endl;
+        return nullptr;
+    }
+    fByName[name] = material;
+    return material;
+}
+
+G4String MaterialCache::MaterialName(const G4String& compositionName) {
+    // Most specific first: "Cooling plate (Cu)" is copper, "baseplate (PCB)" is PCB
+    std::string lower = Lower(compositionName);
+    if (lower.find("air") != std::string::npos) return "G4_AIR";
+    if (lower.find("glue") != std::string::npos) return "Glue";
+    if (lower.find("kapton") != std::string::npos) return "Kapton";
+    if (lower.find("pcb") != std::string::npos) return "PCB";
+    if (lower.find("lead") != std::string::npos) return "G4_Pb";
+    if (lower.find("stainless") != std::string::npos || lower.find("absorber") != std::string::npos) {
+        return "StainlessSteel";
+    }
+    // Cu/W is approximated by copper, as in the hand-written stack
+    if (lower.find("cu") != std::string::npos) return "G4_Cu";
+    if (lower == "si") return "G4_Si";
+    return "";
+}
+
+G4Material* MaterialCache::ForComposition(const G4String& compositionName) {
+    auto it = fByCompositionName.find(compositionName);
+    if (it != fByCompositionName.end()) return it->second;
+
+    G4String name = MaterialName(compositionName);
+    G4Material* material = name.empty() ? nullptr : Get(name);
+    if (!material) {
+        G4cout << "ERROR: No material for composition entry: " << compositionName << G4endl;
+        return nullptr;
+    }
+    fByCompositionName[compositionName] = material;
+    return material;
+}
+
+G4Material* MaterialCache::Mixture(const std::vector<std::pair<G4Material*, G4double>>& arealMass,
+                                   G4double thickness) {
+    G4double totalMass = 0.;
+    for (const auto& entry : arealMass) totalMass += entry.second;
+    if (totalMass <= 0. || thickness <= 0.) return nullptr;
+    G4double density = totalMass / thickness;
+
+    // Key: components, fractions and density, rounded
+    std::ostringstream key;
+    key << std::setprecision(5) << density / (g/cm3);
+    for (const auto& entry : arealMass) {
+        key << ' ' << entry.first->GetName() << ' ' << entry.second / totalMass;
+    }
+    auto it = fByName.find(key.str());
+    if (it != fByName.end()) return it->second;
+
+    G4String name = "PassiveMix_" + std::to_string(fMixtures++);
+    G4Material* mixture = new G4Material(name, density, static_cast<G4int>(arealMass.size()));
+    for (const auto& entry : arealMass) {
+        mixture->AddMaterial(entry.first, entry.second / totalMass);
+    }
+    fByName[key.str()] = mixture;
+    return mixture;
+}
+
+G4bool LayerStack::Read(const G4String& compositionFile, const G4String& radiiFile, const Options& options,
+                        MaterialCache& materials, std::vector<MaterialLayer>& siliconLayers,
+                        std::vector<MaterialLayer>& nonSiliconLayers) {
+    siliconLayers.clear();
+    nonSiliconLayers.clear();
+
+    // Radii, by the z from which they apply
+    std::ifstream radiiStream(radiiFile);
+    if (!radiiStream) {
+        G4cout << "ERROR: Cannot open layer radii table: " << radiiFile << G4endl;
+        return false;
+    }
+    std::string line;
+    std::getline(radiiStream, line);
+    std::vector<std::string> header = SplitRow(line);
+    int radiiZ = FindColumn(header, "Z min");
+    int radiiInner = FindColumn(header, "Inner radius");
+    int radiiOuter = FindColumn(header, "Outer radius");
+    std::vector<RadiiRow> radii;
+    while (std::getline(radiiStream, line)) {
+        std::vector<std::string> fields = SplitRow(line);
+        RadiiRow row;
+        if (!ParseNumber(fields, radiiZ, row.zMin) || !ParseNumber(fields, radiiInner, row.innerRadius) ||
+            !ParseNumber(fields, radiiOuter, row.outerRadius)) continue;
+        radii.push_back(row);
+    }
+    if (radii.empty()) {
+        G4cout << "ERROR: No radii in layer radii table: " << radiiFile << G4endl;
+        return false;
+    }
+    std::sort(radii.begin(), radii.end(), [](const RadiiRow& a, const RadiiRow& b) { return a.zMin < b.zMin; });
+
+    std::ifstream compositionStream(compositionFile);
+    if (!compositionStream) {
+        G4cout << "ERROR: Cannot open layer composition table: " << compositionFile << G4endl;
+        return false;
+    }
+    std::getline(compositionStream, line);
+    header = SplitRow(line);
+    int layerColumn = FindColumn(header, "Layer");
+    int materialColumn = FindColumn(header, "Material");
+    int zMinColumn = FindColumn(header, "Z min");
+    int zMaxColumn = FindColumn(header, "Z max");
+    if (layerColumn < 0 || materialColumn < 0 || zMinColumn < 0 || zMaxColumn < 0) {
+        G4cout << "ERROR: Missing Layer #, Material, Z min or Z max column in " << compositionFile << G4endl;
+        return false;
+    }
+
+    // Passive layers are named after the last sensor in front of them
+    G4int section = 0;
+    G4int indexInSection = 0;
+    std::size_t radiiRow = 0;
+    while (std::getline(compositionStream, line)) {
+        std::vector<std::string> fields = SplitRow(line);
+        G4double zMin = 0., zMax = 0.;
+        if (!ParseNumber(fields, zMinColumn, zMin) || !ParseNumber(fields, zMaxColumn, zMax)) continue;
+        if (zMax <= zMin) continue;
+
+        // Rows come in z order: the radii row only moves forward
+        while (radiiRow + 1 < radii.size() && radii[radiiRow + 1].zMin <= zMin + 1e-6) ++radiiRow;
+        if (zMin + 1e-6 < radii[radiiRow].zMin) {
+            G4cout << "ERROR: No radii for the layer at z = " << zMin << " mm in " << radiiFile << G4endl;
+            return false;
+        }
+
+        const std::string& compositionName = fields[materialColumn];
+        G4double layerNumber = 0.;
+        G4bool isSensor = ParseNumber(fields, layerColumn, layerNumber);
+        if (!isSensor) {
+            std::string lower = Lower(compositionName);
+            if (!options.glue && lower.find("glue") != std::string::npos) continue;
+            if (!options.air && lower.find("air") != std::string::npos) continue;
+        }
+
+        G4Material* material = materials.ForComposition(compositionName);
+        if (!material) return false;
+
+        MaterialLayer layer;
+        layer.material = material;
+        layer.zMin = zMin;
+        layer.zMax = zMax;
+        layer.innerRadius = radii[radiiRow].innerRadius;
+        layer.outerRadius = radii[radiiRow].outerRadius;
+        if (isSensor) {
+            section = static_cast<G4int>(layerNumber);
+            indexInSection = 0;
+            layer.name = "Si_l" + std::to_string(section);
+            layer.layerNumber = section;
+            siliconLayers.push_back(layer);
+        } else {
+            layer.name = CompactName(compositionName) + "_l" + std::to_string(section) + "_"
+                       + std::to_string(++indexInSection);
+            layer.layerNumber = -1;
+            nonSiliconLayers.push_back(layer);
+        }
+    }
+    if (siliconLayers.empty()) {
+        G4cout << "ERROR: No sensor layers in " << compositionFile << G4endl;
+        return false;
+    }
+    return true;
+}
+
+void LayerStack::MergePassive(const std::vector<MaterialLayer>& siliconLayers,
+                              std::vector<MaterialLayer>& nonSiliconLayers, MaterialCache& materials) {
+    std::vector<G4double> sensorZ;
+    for (const auto& layer : siliconLayers) sensorZ.push_back(layer.zMin);
+    std::sort(sensorZ.begin(), sensorZ.end());
+
+    // Group by the number of sensors in front (layers are in z order)
+    std::vector<MaterialLayer> merged;
+    std::size_t begin = 0;
+    while (begin < nonSiliconLayers.size()) {
+        auto sensorsInFront = [&sensorZ](const MaterialLayer& layer) {
+            return std::upper_bound(sensorZ.begin(), sensorZ.end(), layer.zMin) - sensorZ.begin();
+        };
+        long section = sensorsInFront(nonSiliconLayers[begin]);
+        std::size_t end = begin;
+        std::vector<std::pair<G4Material*, G4double>> arealMass;
+        while (end < nonSiliconLayers.size() && sensorsInFront(nonSiliconLayers[end]) == section) {
+            const MaterialLayer& layer = nonSiliconLayers[end];
+            G4double mass = (layer.zMax - layer.zMin) * mm * layer.material->GetDensity();
+            auto it = std::find_if(arealMass.begin(), arealMass.end(),
+                                   [&layer](const std::pair<G4Material*, G4double>& entry) {
+                                       return entry.first == layer.material;
+                                   });
+            if (it == arealMass.end()) {
+                arealMass.emplace_back(layer.material, mass);
+            } else {
+                it->second += mass;
+            }
+            ++end;
+        }
+
+        MaterialLayer slab = nonSiliconLayers[begin];
+        slab.zMax = nonSiliconLayers[end - 1].zMax;
+        slab.name = "Passive_l" + std::to_string(section);
+        slab.material = materials.Mixture(arealMass, (slab.zMax - slab.zMin) * mm);
+        merged.push_back(slab);
+        begin = end;
+    }
+    nonSiliconLayers.swap(merged);
+}
+
+void LayerStack::BuildToy(MaterialCache& materials, std::vector<MaterialLayer>& siliconLayers,
+                          std::vector<MaterialLayer>& nonSiliconLayers) {
+    // Sensor centres (cm) and outer radii (cm) of toy/construction.cc
+    static const G4double kLayerZ[47] = {
+        322.155, 323.149, 325.212, 326.206, 328.269, 329.263, 331.326, 332.32, 334.383, 335.377,
+        337.44, 338.434, 340.497, 341.491, 343.554, 344.548, 346.611, 347.605, 349.993, 350.987,
+        353.375, 354.369, 356.757, 357.751, 360.139, 361.133, 367.976, 374.281, 380.586, 386.891,
+        393.196, 399.501, 405.806, 411.916, 418.221, 424.526, 430.831, 439.056, 447.281, 455.506,
+        463.731, 471.956, 480.181, 488.406, 496.631, 504.856, 513.081
+    };
+    static const G4double kOuterRadius[47] = {
+        150, 142, 150, 142, 150, 142, 150, 142, 150, 150,
+        150, 150, 150, 150, 150, 150, 150, 158, 158, 150,
+        158, 150, 158, 158, 158, 158, 158, 164, 167, 169,
+        167, 178, 183, 197, 206, 215, 215, 234, 245, 256,
+        256, 256, 256, 256, 256, 256, 245
+    };
+    const G4double innerRadius = 15.0;  // cm
+    const G4double siThickness = 0.3;   // mm
+    const G4double gap = 1.0;           // mm, sensor to lead
+    const G4double leadThickness = 5.6; // mm
+
+    siliconLayers.clear();
+    nonSiliconLayers.clear();
+    G4Material* silicon = materials.Get("G4_Si");
+    G4Material* lead = materials.Get("G4_Pb");
+    for (G4int i = 0; i < 47; ++i) {
+        G4int layerNumber = i + 1;
+        G4double zCentre = kLayerZ[i] * 10.;  // mm
+        G4double siZMin = zCentre - siThickness / 2.0;
+        G4double siZMax = zCentre + siThickness / 2.0;
+        siliconLayers.push_back({"Si_l" + std::to_string(layerNumber), silicon, siZMin, siZMax,
+                                 kOuterRadius[i], innerRadius, layerNumber});
+        nonSiliconLayers.push_back({"Lead_l" + std::to_string(layerNumber), lead, siZMax + gap,
+                                    siZMax + gap + leadThickness, kOuterRadius[i], innerRadius, -1});
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef LAYERSTACK_HH
+#define LAYERSTACK_HH
+
+#include "globals.hh"
+#include <unordered_map>
+#include <vector>
+
+class G4Material;
+
+// Structure to hold material layer information
+struct MaterialLayer {
+    G4String name;
+    G4Material* material;
+    G4double zMin;          // mm
+    G4double zMax;          // mm
+    G4double outerRadius;   // cm
+    G4double innerRadius;    // cm
+    G4int layerNumber;      // -1 for non-silicon layers
+};
+
+// Materials of the layer stack, created on first use and cached by name.
+// Get() takes a material name ("G4_Si", "StainlessSteel", ...);
+// ForComposition() takes a name from the composition table ("Cu/W",
+// "Cooling plate (Cu)", "PCB (Hexaboard)", ...).
+class MaterialCache {
+public:
+    G4Material* Get(const G4String& name);
+    G4Material* ForComposition(const G4String& compositionName);
+    // Mixture of the given masses per unit area spread over a thickness,
+    // shared between identical compositions
+    G4Material* Mixture(const std::vector<std::pair<G4Material*, G4double>>& arealMass, G4double thickness);
+
+private:
+    std::unordered_map<std::string, G4Material*> fByName;
+    std::unordered_map<std::string, G4Material*> fByCompositionName;
+    G4int fMixtures = 0;
+
+    static G4String MaterialName(const G4String& compositionName);
+};
+
+// Layer stack read from two tables:
+//   composition: one row per layer in z order ("Layer #" set for sensors,
+//                "Material", "Z min", "Z max" in mm), e.g.
+//                Data/HGCAL_Layers_composition.csv
+//   radii:       "Z min (mm)", "Inner radius (cm)", "Outer radius (cm)"; a row
+//                applies to every layer from its z up to the next row, e.g.
+//                Data/HGCAL_Layers_radii.csv
+// Glue and air rows are skipped unless requested.
+class LayerStack {
+public:
+    struct Options {
+        G4bool glue;
+        G4bool air;
+    };
+
+    // False (with an ERROR message) if a table is missing or malformed
+    static G4bool Read(const G4String& compositionFile, const G4String& radiiFile, const Options& options,
+                       MaterialCache& materials, std::vector<MaterialLayer>& siliconLayers,
+                       std::vector<MaterialLayer>& nonSiliconLayers);
+
+    // Replaces the passive layers between two sensors (and in front of the
+    // first / behind the last) by one slab of their mass-weighted mixture,
+    // spanning them and the gaps in between: mass, X0 and lambda per unit
+    // area are unchanged. The slab takes the radii of its first layer.
+    static void MergePassive(const std::vector<MaterialLayer>& siliconLayers,
+                             std::vector<MaterialLayer>& nonSiliconLayers, MaterialCache& materials);
+
+    // Toy model (toy/construction.cc): 47 silicon sensors, each followed by
+    // 5.6 mm of lead, at the sensor positions of the full stack
+    static void BuildToy(MaterialCache& materials, std::vector<MaterialLayer>& siliconLayers,
+                         std::vector<MaterialLayer>& nonSiliconLayers);
+};
+
+#endif
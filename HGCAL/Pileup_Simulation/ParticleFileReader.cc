@@ -0,0 +1,343 @@
+#include "ParticleFileReader.hh"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace {
+    // Only show the first few malformed lines (shared by all threads)
+    std::atomic<G4int> warningCount{0};
+    const G4int maxWarnings = 20;
+
+    const char* SkipBlanks(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        return p;
+    }
+
+    template <typename T>
+    const char* ParseField(const char* p, const char* end, T& value, G4bool& ok) {
+        p = SkipBlanks(p, end);
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) ok = false;
+        return result.ptr;
+    }
+}
+
+ParticleFileReader::ParticleFileReader()
+    : fBegin(nullptr), fEnd(nullptr),
+      fBinary(false), fHeader(nullptr), fEventOffsets(nullptr), fRecords(nullptr),
+      fIndexed(false), fFirstEventID(0) {}
+
+ParticleFileReader::~ParticleFileReader() {}
+
+G4bool ParticleFileReader::Open(const G4String& filename) {
+    Close();
+
+    G4cout << "======================================" << G4endl;
+    G4cout << "Attempting to open file: " << filename << G4endl;
+
+    if (!fFile.Open(filename)) {
+        G4cout << "ERROR: Cannot open particle file: " << filename << G4endl;
+        return false;
+    }
+
+    // Binary files are recognised by their magic
+    const char* data = fFile.Data();
+    if (fFile.Size() >= sizeof(ParticleFileHeader) &&
+        std::memcmp(data, "HGCPART1", 8) == 0) {
+        return OpenBinary();
+    }
+
+    // Skip header line
+    fEnd = data + fFile.Size();
+    const char* eol = static_cast<const char*>(std::memchr(data, '\n', fFile.Size()));
+    if (!eol) {
+        G4cout << "ERROR: Cannot read header line!" << G4endl;
+        fFile.Close();
+        return false;
+    }
+    fBegin = eol + 1;
+    G4cout << "Header: " << std::string(data, eol - data) << G4endl;
+
+    G4cout << "Mapped " << fFile.Size() / (1024.0 * 1024.0) << " MB from " << filename
+           << " (events are decoded on demand, Evt# order is checked around each one)" << G4endl;
+    G4cout << "======================================" << G4endl;
+    return true;
+}
+
+G4bool ParticleFileReader::OpenBinary() {
+    fBinary = true;
+    fHeader = reinterpret_cast<const ParticleFileHeader*>(fFile.Data());
+
+    // Widen before adding so nEvents = UINT32_MAX cannot wrap, and bound
+    // nRecords by the file size before multiplying
+    const std::uint64_t nOffsets = static_cast<std::uint64_t>(fHeader->nEvents) + 1;
+    const std::uint64_t size = fFile.Size();
+    G4bool valid = fHeader->version == 1 && fHeader->recordSize == sizeof(ParticleRecord) &&
+                   fHeader->nRecords <= size / sizeof(ParticleRecord);
+    if (valid) {
+        std::uint64_t expected = sizeof(ParticleFileHeader)
+                               + nOffsets * sizeof(std::uint64_t)
+                               + fHeader->nRecords * sizeof(ParticleRecord);
+        valid = size >= expected;
+    }
+    if (!valid) {
+        G4cout << "ERROR: Unsupported or truncated binary particle file: "
+               << fFile.GetFileName() << G4endl;
+        Close();
+        return false;
+    }
+
+    fEventOffsets = reinterpret_cast<const std::uint64_t*>(fFile.Data() + sizeof(ParticleFileHeader));
+    fRecords = reinterpret_cast<const ParticleRecord*>(fEventOffsets + nOffsets);
+
+    // Validate the offset table once so ReadEvent can index records unchecked
+    for (std::uint64_t i = 0; i < nOffsets; ++i) {
+        if (fEventOffsets[i] > fHeader->nRecords || (i > 0 && fEventOffsets[i] < fEventOffsets[i - 1])) {
+            G4cout << "ERROR: Corrupt event offset table in binary particle file: "
+                   << fFile.GetFileName() << G4endl;
+            Close();
+            return false;
+        }
+    }
+
+    G4cout << "Binary particle file: " << fHeader->nRecords << " particles in "
+           << fHeader->nEvents << " events (Evt# " << fHeader->firstEventID << " to "
+           << fHeader->firstEventID + static_cast<G4int>(fHeader->nEvents) - 1 << ")" << G4endl;
+    G4cout << "======================================" << G4endl;
+    return true;
+}
+
+void ParticleFileReader::Close() {
+    fFile.Close();
+    fBegin = fEnd = nullptr;
+    fBinary = false;
+    fHeader = nullptr;
+    fEventOffsets = nullptr;
+    fRecords = nullptr;
+    fIndexed.store(false, std::memory_order_relaxed);
+    fLineOffsets.clear();
+    fEventIndex.clear();
+    fFirstEventID = 0;
+}
+
+G4bool ParticleFileReader::ReadEvent(G4int eventID, std::vector<ParticleGenInfo>& particles) const {
+    particles.clear();
+    if (!IsOpen()) return false;
+
+    ParticleGenInfo particle;
+    auto accept = [&](const char* line) {
+        if (!ParseLine(line, particle)) return;
+        // Skip particles with invalid values (inf, nan, zero pt)
+        if (std::isfinite(particle.eta) && std::isfinite(particle.pt) &&
+            std::isfinite(particle.phi) && std::isfinite(particle.theta) &&
+            particle.pt > 0.0) {
+            particles.push_back(particle);
+        } else if (warningCount++ < maxWarnings) {
+            G4cout << "WARNING: Skipping particle with invalid values (inf/nan/zero) in event "
+                   << eventID << G4endl;
+        }
+    };
+
+    if (fBinary) {
+        G4int slot = eventID - fHeader->firstEventID;
+        if (slot < 0 || slot >= static_cast<G4int>(fHeader->nEvents)) return false;
+        for (std::uint64_t i = fEventOffsets[slot]; i < fEventOffsets[slot + 1]; ++i) {
+            const ParticleRecord& record = fRecords[i];
+            particles.push_back({record.eventID, record.cumTr, record.pdgID,
+                                 record.pt, record.phi, record.theta, record.eta});
+        }
+        return true;
+    }
+
+    if (!fIndexed.load(std::memory_order_acquire)) {
+        const char* first = nullptr;
+        const char* last = nullptr;
+        if (FindEventLines(eventID, first, last)) {
+            if (first == last) return false;
+            for (const char* line = first; line < last; line = NextLine(line)) {
+                accept(line);
+            }
+            return true;
+        }
+        EnsureLineIndex(eventID);
+    }
+
+    // Unsorted text: through the line index
+    G4int slot = eventID - fFirstEventID;
+    if (slot < 0 || slot >= static_cast<G4int>(fEventIndex.size()) || fEventIndex[slot].count == 0)
+        return false;
+    const EventRange& range = fEventIndex[slot];
+    for (std::size_t i = range.offset; i < range.offset + range.count; ++i) {
+        accept(fBegin + fLineOffsets[i]);
+    }
+    return true;
+}
+
+G4bool ParticleFileReader::GetEventRange(G4int& firstEventID, G4int& lastEventID) const {
+    if (!IsOpen()) return false;
+
+    if (fBinary) {
+        if (fHeader->nEvents == 0) return false;
+        firstEventID = fHeader->firstEventID;
+        lastEventID = fHeader->firstEventID + static_cast<G4int>(fHeader->nEvents) - 1;
+        return true;
+    }
+    if (fIndexed.load(std::memory_order_acquire)) {
+        if (fEventIndex.empty()) return false;
+        firstEventID = fFirstEventID;
+        lastEventID = fFirstEventID + static_cast<G4int>(fEventIndex.size()) - 1;
+        return true;
+    }
+
+    // Text assumed sorted: first valid line, then walk back from the end to the last valid one
+    const char* first = fBegin;
+    while (first < fEnd && LineEventID(first) == INT_MAX) first = NextLine(first);
+    if (first >= fEnd) return false;
+    firstEventID = LineEventID(first);
+
+    const char* p = fEnd;
+    while (p > first) {
+        const char* line = p - 1;
+        if (line > fBegin && *line == '\n') --line;  // step over this line's newline
+        while (line > fBegin && line[-1] != '\n') --line;
+        G4int id = LineEventID(line);
+        if (id != INT_MAX) {
+            lastEventID = id;
+            return true;
+        }
+        p = line;
+    }
+    lastEventID = firstEventID;
+    return true;
+}
+
+G4bool ParticleFileReader::CheckOrder() {
+    if (fBinary || !IsOpen()) return true;
+    G4int lastID = INT_MIN;
+    for (const char* line = fBegin; line < fEnd; line = NextLine(line)) {
+        G4int id = LineEventID(line);
+        if (id < lastID) {
+            EnsureLineIndex(id);
+            return false;
+        }
+        lastID = id;
+    }
+    return true;
+}
+
+void ParticleFileReader::EnsureLineIndex(G4int eventID) const {
+    std::lock_guard<std::mutex> lock(fIndexMutex);
+    if (fIndexed.load(std::memory_order_relaxed)) return;
+    G4cout << "WARNING: Particle file is not sorted by Evt# (found reading event " << eventID
+           << "), indexing all lines once..." << G4endl;
+    BuildLineIndex();
+    fIndexed.store(true, std::memory_order_release);
+}
+
+void ParticleFileReader::BuildLineIndex() const {
+    std::vector<std::pair<G4int, std::size_t>> lines;
+    for (const char* line = fBegin; line < fEnd; line = NextLine(line)) {
+        G4int id = LineEventID(line);
+        if (id != INT_MAX) lines.emplace_back(id, static_cast<std::size_t>(line - fBegin));
+    }
+    if (lines.empty()) return;
+
+    // Stable sort keeps the Cum_Tr# order within each event
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    fFirstEventID = lines.front().first;
+    fEventIndex.assign(lines.back().first - fFirstEventID + 1, EventRange{0, 0});
+    fLineOffsets.resize(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        fLineOffsets[i] = lines[i].second;
+        EventRange& range = fEventIndex[lines[i].first - fFirstEventID];
+        if (range.count == 0) range.offset = i;
+        range.count++;
+    }
+}
+
+G4bool ParticleFileReader::FindEventLines(G4int eventID, const char*& first, const char*& last) const {
+    // Lines of the event in [first, last), empty if it is not in the file.
+    // False if the lines looked at contradict Evt# order: the line before the
+    // event must belong to an earlier one, the line after it to a later one
+    // (or be blank or malformed, which is only expected at the end).
+    if (!FindFirstLine(eventID, first)) return false;
+    if (first > fBegin && LineEventID(PreviousLine(first)) >= eventID) return false;
+    last = first;
+    while (last < fEnd && LineEventID(last) == eventID) last = NextLine(last);
+    return last >= fEnd || LineEventID(last) > eventID;
+}
+
+G4bool ParticleFileReader::FindFirstLine(G4int eventID, const char*& first) const {
+    // Smallest line start whose Evt# is >= eventID. Each probe must lie between
+    // the Evt# already seen below and above it, otherwise the file is unsorted.
+    const char* lo = fBegin;
+    const char* hi = fEnd;
+    G4int lowID = INT_MIN;
+    G4int highID = INT_MAX;
+    while (lo < hi) {
+        const char* mid = LineStartAtOrAfter(lo + (hi - lo) / 2);
+        if (mid >= hi) mid = lo;
+        G4int id = LineEventID(mid);
+        if (id < lowID || id > highID) return false;
+        if (id < eventID) {
+            lo = NextLine(mid);
+            lowID = id;
+        } else {
+            hi = mid;
+            highID = id;
+        }
+    }
+    first = lo;
+    return true;
+}
+
+const char* ParticleFileReader::LineStartAtOrAfter(const char* p) const {
+    if (p <= fBegin) return fBegin;
+    if (p[-1] == '\n') return p;
+    return NextLine(p);
+}
+
+const char* ParticleFileReader::PreviousLine(const char* p) const {
+    // p is a line start after fBegin: step over the previous line's newline
+    const char* line = p - 1;
+    while (line > fBegin && line[-1] != '\n') --line;
+    return line;
+}
+
+const char* ParticleFileReader::NextLine(const char* p) const {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', fEnd - p));
+    return eol ? eol + 1 : fEnd;
+}
+
+G4int ParticleFileReader::LineEventID(const char* line) const {
+    G4int id = 0;
+    G4bool ok = true;
+    const char* p = ParseField(line, fEnd, id, ok);
+    // Blank/malformed lines sort after every event (only trailing ones are expected)
+    if (!ok || p == line) return INT_MAX;
+    return id;
+}
+
+G4bool ParticleFileReader::ParseLine(const char* line, ParticleGenInfo& particle) const {
+    // Read 7 columns: Evt#, Cum_Tr#, PDG_ID, Pt, Phi, Theta, Eta
+    G4bool ok = true;
+    const char* p = line;
+    p = ParseField(p, fEnd, particle.eventID, ok);
+    p = ParseField(p, fEnd, particle.cumTr, ok);
+    p = ParseField(p, fEnd, particle.pdgID, ok);
+    p = ParseField(p, fEnd, particle.pt, ok);
+    p = ParseField(p, fEnd, particle.phi, ok);
+    p = ParseField(p, fEnd, particle.theta, ok);
+    p = ParseField(p, fEnd, particle.eta, ok);
+    if (!ok && warningCount++ < maxWarnings) {
+        const char* eol = NextLine(line);
+        G4cout << "WARNING: Failed to parse line: " << std::string(line, eol - line) << G4endl;
+    }
+    return ok;
+}
@@ -0,0 +1,123 @@
+#ifndef PARTICLEFILEREADER_HH
+#define PARTICLEFILEREADER_HH
+
+#include "globals.hh"
+#include "MappedFile.hh"
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Structure to hold particle generation information from file
+struct ParticleGenInfo {
+    G4int eventID;      // Evt#
+    G4int cumTr;        // Cum_Tr#
+    G4int pdgID;        // PDG_ID
+    G4double pt;        // Pt
+    G4double phi;       // Phi
+    G4double theta;     // Theta
+    G4double eta;       // Eta
+};
+
+// Location of one event's particles inside the particle list
+struct EventRange {
+    std::size_t offset;  // index of the first particle of the event
+    std::size_t count;   // number of particles in the event
+};
+
+// Compact binary particle file ("HGCPART1"), written by convert_particles:
+//   ParticleFileHeader
+//   uint64_t eventOffsets[nEvents + 1]   first record of event (firstEventID + i)
+//   ParticleRecord records[nRecords]     already filtered for inf/nan/zero pT
+// All values are little-endian; records are grouped by event in Evt# order.
+struct ParticleFileHeader {
+    char magic[8];            // "HGCPART1"
+    std::uint32_t version;    // 1
+    std::uint32_t recordSize; // sizeof(ParticleRecord)
+    std::int32_t firstEventID;
+    std::uint32_t nEvents;
+    std::uint64_t nRecords;
+};
+
+struct ParticleRecord {
+    std::int32_t eventID;
+    std::int32_t cumTr;
+    std::int32_t pdgID;
+    float pt;                 // text input carries 4 decimals, float is exact enough
+    float phi;
+    float theta;
+    float eta;
+};
+
+static_assert(sizeof(ParticleFileHeader) == 32, "unexpected ParticleFileHeader padding");
+static_assert(sizeof(ParticleRecord) == 28, "unexpected ParticleRecord padding");
+
+// Streaming reader for generated_data.txt (header line + 7 columns per line).
+// The file is memory-mapped and only the requested event is decoded, so
+// opening costs the same for any file size. Lines of an event are located by
+// binary search over the byte range, which relies on the file being sorted by
+// Evt#. The order is checked only on the lines a read touches (the search
+// probes, the event and its neighbouring lines); the first read that finds it
+// broken builds a one-time index of all line offsets, used from then on.
+// Binary files (see above) are detected from their magic and served by
+// seeking straight to the event through the offset table.
+// ReadEvent() is const and may be called concurrently from worker threads.
+class ParticleFileReader {
+public:
+    ParticleFileReader();
+    ~ParticleFileReader();
+
+    G4bool Open(const G4String& filename);
+    void Close();
+    G4bool IsOpen() const { return fFile.IsOpen(); }
+    const G4String& GetFileName() const { return fFile.GetFileName(); }
+
+    // Decode all valid particles of one event into 'particles' (cleared
+    // first, capacity kept). Returns false if the event is not in the file.
+    G4bool ReadEvent(G4int eventID, std::vector<ParticleGenInfo>& particles) const;
+
+    // Smallest and largest Evt# present in the file (for text files not
+    // indexed yet: the Evt# of the first and last valid line)
+    G4bool GetEventRange(G4int& firstEventID, G4int& lastEventID) const;
+
+    G4bool IsBinary() const { return fBinary; }
+
+    // Full pass over a text file: true if sorted by Evt#, otherwise the line
+    // index is built now. Reads the whole file, so it is meant for tools that
+    // visit every event anyway (convert_particles), not for the simulation.
+    G4bool CheckOrder();
+
+private:
+    MappedFile fFile;
+    const char* fBegin;  // first byte after the header line
+    const char* fEnd;
+
+    // Binary format
+    G4bool fBinary;
+    const ParticleFileHeader* fHeader;
+    const std::uint64_t* fEventOffsets;
+    const ParticleRecord* fRecords;
+
+    // Fallback index for unsorted files: line starts grouped by event.
+    // Built at most once, by the first read (any thread) that finds the
+    // order broken; fIndexed is set once it is complete.
+    mutable std::atomic<G4bool> fIndexed;
+    mutable std::mutex fIndexMutex;
+    mutable std::vector<std::size_t> fLineOffsets;
+    mutable std::vector<EventRange> fEventIndex;
+    mutable G4int fFirstEventID;
+
+    G4bool OpenBinary();
+    void EnsureLineIndex(G4int eventID) const;
+    void BuildLineIndex() const;
+    G4bool FindEventLines(G4int eventID, const char*& first, const char*& last) const;
+    G4bool FindFirstLine(G4int eventID, const char*& first) const;
+    const char* LineStartAtOrAfter(const char* p) const;
+    const char* PreviousLine(const char* p) const;
+    const char* NextLine(const char* p) const;
+    G4int LineEventID(const char* line) const;
+    G4bool ParseLine(const char* line, ParticleGenInfo& particle) const;
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "ShowerLibrary.hh"
+#include "G4Track.hh"
+#include "G4Region.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const G4double kEnergyEdges[ShowerLibrary::kNumEnergyBins + 1] =
+        {0.5, 1., 2., 5., 10., 20., 50., 100.};                    // MeV
+    const G4double kDepthEdges[ShowerLibrary::kNumDepthBins + 1] =
+        {0., 0.5, 1., 2., 4., 8., 16., 32., 64., 128.};             // mm
+
+    // Bin of value in ascending edges, -1 outside
+    G4int FindBin(const G4double* edges, G4int nBins, G4double value) {
+        if (value < edges[0] || value >= edges[nBins]) return -1;
+        return static_cast<G4int>(std::upper_bound(edges, edges + nBins + 1, value) - edges) - 1;
+    }
+
+    // Deposits of a recorded shower are merged on this transverse grid,
+    // finer than any cell so that stamping still resolves the cell
+    const G4double kDepositGrid = 1.0 * mm;
+}
+
+const G4double ShowerLibrary::kMinEnergy = 0.5 * MeV;
+const G4double ShowerLibrary::kMaxEnergy = 100. * MeV;
+
+std::atomic<G4int> ShowerLibrary::fMode{ShowerLibrary::kOff};
+
+// ------------------------------------------------------------
+// ShowerLibrary
+// ------------------------------------------------------------
+
+ShowerLibrary& ShowerLibrary::Instance()
+{
+    static ShowerLibrary instance;
+    return instance;
+}
+
+ShowerLibrary::ShowerLibrary()
+: fFileName("shower_library.bin"), fMaxShowersPerBin(200),
+  fHeader(nullptr), fBinOffsets(nullptr), fShowers(nullptr), fDeposits(nullptr),
+  fStored(kNumBins), fStoredCount(new std::atomic<G4int>[kNumBins])
+{
+    for (G4int bin = 0; bin < kNumBins; ++bin) {
+        fStoredCount[bin].store(0, std::memory_order_relaxed);
+    }
+}
+
+ShowerLibrary::~ShowerLibrary() {}
+
+G4int ShowerLibrary::Species(G4int pdgCode)
+{
+    switch (pdgCode) {
+        case 22:  return 0;
+        case 11:  return 1;
+        case -11: return 2;
+        default:  return -1;
+    }
+}
+
+G4int ShowerLibrary::BinIndex(G4int species, G4double energy, G4double depth, G4double cosTheta)
+{
+    if (species < 0) return -1;
+    G4int energyBin = FindBin(kEnergyEdges, kNumEnergyBins, energy / MeV);
+    G4int depthBin = FindBin(kDepthEdges, kNumDepthBins, depth / mm);
+    if (energyBin < 0 || depthBin < 0) return -1;
+    G4int angleBin = std::min(static_cast<G4int>(std::abs(cosTheta) * kNumAngleBins), kNumAngleBins - 1);
+    return ((species * kNumEnergyBins + energyBin) * kNumDepthBins + depthBin) * kNumAngleBins + angleBin;
+}
+
+G4bool ShowerLibrary::MakeFrame(const G4ThreeVector& position, const G4ThreeVector& direction,
+                                const std::vector<SiliconPlane>& planes, ShowerFrame& frame)
+{
+    G4double z = position.z();
+    frame.cosTheta = direction.z();
+    if (frame.cosTheta >= 0.) {
+        auto it = std::find_if(planes.begin(), planes.end(),
+                               [z](const SiliconPlane& plane) { return plane.zMin >= z; });
+        if (it == planes.end()) return false;
+        frame.refPlane = static_cast<G4int>(it - planes.begin());
+        frame.depth = it->zMin - z;
+    } else {
+        auto it = std::find_if(planes.rbegin(), planes.rend(),
+                               [z](const SiliconPlane& plane) { return plane.zMax <= z; });
+        if (it == planes.rend()) return false;
+        frame.refPlane = static_cast<G4int>(planes.rend() - it) - 1;
+        frame.depth = z - it->zMax;
+    }
+
+    // u along the transverse direction (any axis for particles along z)
+    G4ThreeVector transverse(direction.x(), direction.y(), 0.);
+    frame.u = (transverse.mag2() > 1e-12) ? transverse.unit() : G4ThreeVector(1., 0., 0.);
+    frame.v = G4ThreeVector(-frame.u.y(), frame.u.x(), 0.);
+    return true;
+}
+
+G4bool ShowerLibrary::Open()
+{
+    Close();
+    if (!fFile.Open(fFileName)) {
+        G4cout << "ERROR: Cannot open shower library: " << fFileName << G4endl;
+        return false;
+    }
+
+    const ShowerLibraryHeader* header = reinterpret_cast<const ShowerLibraryHeader*>(fFile.Data());
+    G4bool valid = fFile.Size() >= sizeof(ShowerLibraryHeader) &&
+                   std::memcmp(header->magic, "HGCSHLB1", 8) == 0 &&
+                   header->version == 1 && header->nBins == static_cast<std::uint32_t>(kNumBins);
+    if (valid) {
+        // Bound the counts by the file size first so the sum cannot wrap
+        const std::uint64_t size = fFile.Size();
+        valid = header->nShowers <= size / sizeof(ShowerRecord) &&
+                header->nDeposits <= size / sizeof(ShowerDeposit);
+        if (valid) {
+            std::uint64_t expected = sizeof(ShowerLibraryHeader)
+                                   + (static_cast<std::uint64_t>(header->nBins) + 1) * sizeof(std::uint64_t)
+                                   + header->nShowers * sizeof(ShowerRecord)
+                                   + header->nDeposits * sizeof(ShowerDeposit);
+            valid = size >= expected;
+        }
+    }
+    if (valid) {
+        // Draw and Deposits index straight from these tables, so check them once here
+        const std::uint64_t* binOffsets = reinterpret_cast<const std::uint64_t*>(fFile.Data() + sizeof(ShowerLibraryHeader));
+        const ShowerRecord* showers = reinterpret_cast<const ShowerRecord*>(binOffsets + header->nBins + 1);
+        for (std::uint32_t bin = 0; valid && bin <= header->nBins; ++bin) {
+            valid = binOffsets[bin] <= header->nShowers && (bin == 0 || binOffsets[bin] >= binOffsets[bin - 1]);
+        }
+        for (std::uint64_t i = 0; valid && i < header->nShowers; ++i) {
+            valid = showers[i].firstDeposit <= header->nDeposits &&
+                    showers[i].nDeposits <= header->nDeposits - showers[i].firstDeposit;
+        }
+    }
+    if (!valid) {
+        G4cout << "ERROR: Unsupported, truncated or corrupt shower library: " << fFileName << G4endl;
+        fFile.Close();
+        return false;
+    }
+
+    fHeader = header;
+    fBinOffsets = reinterpret_cast<const std::uint64_t*>(fFile.Data() + sizeof(ShowerLibraryHeader));
+    fShowers = reinterpret_cast<const ShowerRecord*>(fBinOffsets + fHeader->nBins + 1);
+    fDeposits = reinterpret_cast<const ShowerDeposit*>(fShowers + fHeader->nShowers);
+
+    G4int filledBins = 0;
+    for (G4int bin = 0; bin < kNumBins; ++bin) {
+        if (HasShowers(bin)) filledBins++;
+    }
+    G4cout << "Shower library " << fFileName << ": " << fHeader->nShowers << " showers, "
+           << fHeader->nDeposits << " deposits, " << filledBins << "/" << kNumBins
+           << " bins filled" << G4endl;
+    return true;
+}
+
+void ShowerLibrary::Close()
+{
+    fFile.Close();
+    fHeader = nullptr;
+    fBinOffsets = nullptr;
+    fShowers = nullptr;
+    fDeposits = nullptr;
+}
+
+const ShowerRecord& ShowerLibrary::Draw(G4int bin) const
+{
+    std::uint64_t first = fBinOffsets[bin];
+    std::uint64_t count = fBinOffsets[bin + 1] - first;
+    std::uint64_t pick = std::min(static_cast<std::uint64_t>(G4UniformRand() * count), count - 1);
+    return fShowers[first + pick];
+}
+
+G4bool ShowerLibrary::IsBinFull(G4int bin) const
+{
+    return fStoredCount[bin].load(std::memory_order_relaxed) >= fMaxShowersPerBin.load(std::memory_order_relaxed);
+}
+
+void ShowerLibrary::AddShower(G4int bin, G4double energy, const std::vector<ShowerDeposit>& deposits)
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (static_cast<G4int>(fStored[bin].size()) >= fMaxShowersPerBin.load(std::memory_order_relaxed)) return;
+    fStored[bin].push_back({static_cast<float>(energy / MeV), deposits});
+    fStoredCount[bin].store(static_cast<G4int>(fStored[bin].size()), std::memory_order_relaxed);
+}
+
+void ShowerLibrary::ClearShowers()
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (G4int bin = 0; bin < kNumBins; ++bin) {
+        fStored[bin].clear();
+        fStoredCount[bin].store(0, std::memory_order_relaxed);
+    }
+}
+
+G4bool ShowerLibrary::Write()
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    ShowerLibraryHeader header;
+    std::memcpy(header.magic, "HGCSHLB1", 8);
+    header.version = 1;
+    header.nBins = kNumBins;
+    header.nShowers = 0;
+    header.nDeposits = 0;
+
+    std::vector<std::uint64_t> binOffsets;
+    std::vector<ShowerRecord> showers;
+    std::vector<ShowerDeposit> deposits;
+    binOffsets.reserve(kNumBins + 1);
+    for (const auto& bin : fStored) {
+        binOffsets.push_back(showers.size());
+        for (const StoredShower& shower : bin) {
+            showers.push_back({deposits.size(), shower.energy,
+                               static_cast<std::uint32_t>(shower.deposits.size())});
+            deposits.insert(deposits.end(), shower.deposits.begin(), shower.deposits.end());
+        }
+    }
+    binOffsets.push_back(showers.size());
+    header.nShowers = showers.size();
+    header.nDeposits = deposits.size();
+
+    std::ofstream out(fFileName, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(binOffsets.data()), binOffsets.size() * sizeof(std::uint64_t));
+    out.write(reinterpret_cast<const char*>(showers.data()), showers.size() * sizeof(ShowerRecord));
+    out.write(reinterpret_cast<const char*>(deposits.data()), deposits.size() * sizeof(ShowerDeposit));
+    if (!out) {
+        G4cout << "ERROR: Cannot write shower library: " << fFileName << G4endl;
+        return false;
+    }
+
+    G4int filledBins = static_cast<G4int>(std::count_if(fStored.begin(), fStored.end(),
+        [](const std::vector<StoredShower>& bin) { return !bin.empty(); }));
+    G4cout << "Shower library written to " << fFileName << ": " << header.nShowers << " showers, "
+           << header.nDeposits << " deposits, " << filledBins << "/" << kNumBins << " bins filled" << G4endl;
+    return true;
+}
+
+// ------------------------------------------------------------
+// ShowerLibraryRecorder
+// ------------------------------------------------------------
+
+ShowerLibraryRecorder& ShowerLibraryRecorder::Instance()
+{
+    static G4ThreadLocal ShowerLibraryRecorder* instance = nullptr;
+    if (!instance) {
+        instance = new ShowerLibraryRecorder();
+    }
+    return *instance;
+}
+
+ShowerLibraryRecorder::ShowerLibraryRecorder() : fPlanes(nullptr) {}
+
+void ShowerLibraryRecorder::BeginTrack(const G4Track* track)
+{
+    if (track->GetParentID() == 0) return;
+
+    // Descendants belong to the shower of their root
+    auto parent = fTrackRoot.find(track->GetParentID());
+    if (parent != fTrackRoot.end()) {
+        fTrackRoot[track->GetTrackID()] = parent->second;
+        return;
+    }
+
+    G4int species = ShowerLibrary::Species(track->GetDefinition()->GetPDGEncoding());
+    G4double energy = track->GetKineticEnergy();
+    if (species < 0 || energy < ShowerLibrary::kMinEnergy || energy >= ShowerLibrary::kMaxEnergy) return;
+
+    const G4Region* region = track->GetVolume()->GetLogicalVolume()->GetRegion();
+    if (!region || region->GetName() != "EMAbsorbers") return;
+
+    if (!fPlanes) {
+        const MyDetectorConstruction* detector = static_cast<const MyDetectorConstruction*>(
+            G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        fPlanes = &detector->GetSiliconPlanes();
+    }
+
+    ShowerFrame frame;
+    if (!ShowerLibrary::MakeFrame(track->GetPosition(), track->GetMomentumDirection(), *fPlanes, frame)) return;
+    G4int bin = ShowerLibrary::BinIndex(species, energy, frame.depth, frame.cosTheta);
+    if (bin < 0 || ShowerLibrary::Instance().IsBinFull(bin)) return;
+
+    fTrackRoot[track->GetTrackID()] = static_cast<G4int>(fRoots.size());
+    fRoots.push_back({bin, energy, frame.refPlane, track->GetPosition(), frame.u, frame.v, {}});
+}
+
+void ShowerLibraryRecorder::AddDeposit(G4int trackID, G4int layer, const G4ThreeVector& position, G4double edep)
+{
+    auto it = fTrackRoot.find(trackID);
+    if (it == fTrackRoot.end()) return;
+
+    Root& root = fRoots[it->second];
+    G4ThreeVector offset = position - root.origin;
+    G4int dPlane = (layer - 1) - root.refPlane;
+    float du = static_cast<float>(std::round(offset.dot(root.u) / kDepositGrid) * kDepositGrid / mm);
+    float dv = static_cast<float>(std::round(offset.dot(root.v) / kDepositGrid) * kDepositGrid / mm);
+    float fraction = static_cast<float>(edep / root.energy);
+
+    for (ShowerDeposit& deposit : root.deposits) {
+        if (deposit.dPlane == dPlane && deposit.du == du && deposit.dv == dv) {
+            deposit.fraction += fraction;
+            return;
+        }
+    }
+    root.deposits.push_back({dPlane, du, dv, fraction});
+}
+
+void ShowerLibraryRecorder::EndOfEvent()
+{
+    ShowerLibrary& library = ShowerLibrary::Instance();
+    for (const Root& root : fRoots) {
+        library.AddShower(root.bin, root.energy, root.deposits);
+    }
+    fRoots.clear();
+    fTrackRoot.clear();
+}
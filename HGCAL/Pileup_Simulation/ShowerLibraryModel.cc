@@ -0,0 +1,84 @@
+#include "ShowerLibraryModel.hh"
+#include "detector.hh"
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Track.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SDManager.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+MyShowerLibraryModel::MyShowerLibraryModel(const G4String& name, G4Region* region)
+: G4VFastSimulationModel(name, region), fPlanes(nullptr), fSensitiveDetector(nullptr), fBin(-1) {}
+
+MyShowerLibraryModel::~MyShowerLibraryModel() {}
+
+G4bool MyShowerLibraryModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return ShowerLibrary::Species(particle.GetPDGEncoding()) >= 0;
+}
+
+G4bool MyShowerLibraryModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+    if (ShowerLibrary::GetMode() != ShowerLibrary::kUse) return false;
+    ShowerLibrary& library = ShowerLibrary::Instance();
+    if (!library.IsOpen()) return false;
+
+    // Secondaries on their first step, i.e. started in the absorbers
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    if (track->GetParentID() == 0 || track->GetCurrentStepNumber() != 1) return false;
+
+    G4double energy = track->GetKineticEnergy();
+    if (energy < ShowerLibrary::kMinEnergy || energy >= ShowerLibrary::kMaxEnergy) return false;
+
+    if (!fPlanes) {
+        const MyDetectorConstruction* detector = static_cast<const MyDetectorConstruction*>(
+            G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        fPlanes = &detector->GetSiliconPlanes();
+    }
+    if (!ShowerLibrary::MakeFrame(track->GetPosition(), track->GetMomentumDirection(), *fPlanes, fFrame)) {
+        return false;
+    }
+    fBin = ShowerLibrary::BinIndex(ShowerLibrary::Species(track->GetDefinition()->GetPDGEncoding()),
+                                   energy, fFrame.depth, fFrame.cosTheta);
+    return fBin >= 0 && library.HasShowers(fBin);
+}
+
+void MyShowerLibraryModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    G4double energy = track->GetKineticEnergy();
+
+    if (!fSensitiveDetector) {
+        fSensitiveDetector = dynamic_cast<MySensitiveDetector*>(
+            G4SDManager::GetSDMpointer()->FindSensitiveDetector("SensitiveDetector"));
+    }
+
+    const ShowerLibrary& library = ShowerLibrary::Instance();
+    const ShowerRecord& shower = library.Draw(fBin);
+    const ShowerDeposit* deposits = library.Deposits(shower);
+    G4double mirror = (G4UniformRand() < 0.5) ? -1.0 : 1.0;
+    const G4ThreeVector& origin = track->GetPosition();
+    G4int nPlanes = static_cast<G4int>(fPlanes->size());
+
+    for (std::uint32_t i = 0; fSensitiveDetector && i < shower.nDeposits; ++i) {
+        const ShowerDeposit& deposit = deposits[i];
+        G4int index = fFrame.refPlane + deposit.dPlane;
+        if (index < 0 || index >= nPlanes) continue;
+        const SiliconPlane& plane = (*fPlanes)[index];
+
+        G4ThreeVector position = origin + (deposit.du * mm) * fFrame.u + (mirror * deposit.dv * mm) * fFrame.v;
+        G4double zCentre = 0.5 * (plane.zMin + plane.zMax);
+        position.setZ(zCentre);
+        if (position.perp() < plane.innerRadius || position.perp() > plane.outerRadius) continue;
+
+        fSensitiveDetector->AddParameterisedDeposit(track, plane.layer, position, deposit.fraction * energy,
+                                                    track->GetGlobalTime(), zCentre);
+    }
+
+    // The whole kinetic energy stays in this step; only the silicon part is recorded
+    fastStep.KillPrimaryTrack();
+    fastStep.ProposePrimaryTrackPathLength(0.0);
+    fastStep.ProposeTotalEnergyDeposited(energy);
+}
@@ -3,6 +3,7 @@
 
 #include "G4VUserTrackInformation.hh"
 #include "G4VUserPrimaryParticleInformation.hh"
+#include "G4Track.hh"
 #include "globals.hh"
 
 // For primary particles (before tracking starts)
@@ -25,18 +26,36 @@ private:
 // For tracks (during simulation)
 class TrackInformation : public G4VUserTrackInformation {
 public:
-    TrackInformation(G4int cumTr) : fCumTr(cumTr) {}
+    TrackInformation(G4int cumTr, G4int boundaryIndex = -1) : fCumTr(cumTr), fBoundaryIndex(boundaryIndex) {}
     virtual ~TrackInformation() {}
     
     G4int GetCumTr() const { return fCumTr; }
     void SetCumTr(G4int cumTr) { fCumTr = cumTr; }
+
+    // Index of the particle (this track or an ancestor) that entered the
+    // calorimeter, -1 if none (BoundaryTruth)
+    G4int GetBoundaryIndex() const { return fBoundaryIndex; }
+    void SetBoundaryIndex(G4int boundaryIndex) { fBoundaryIndex = boundaryIndex; }
+
+    // cumTr of a track, -1 if not set. TrackInformation is the only track
+    // information in this application, so no dynamic_cast is needed per step.
+    static G4int CumTrOf(const G4Track* track) {
+        const G4VUserTrackInformation* info = track->GetUserInformation();
+        return info ? static_cast<const TrackInformation*>(info)->fCumTr : -1;
+    }
+
+    static G4int BoundaryIndexOf(const G4Track* track) {
+        const G4VUserTrackInformation* info = track->GetUserInformation();
+        return info ? static_cast<const TrackInformation*>(info)->fBoundaryIndex : -1;
+    }
     
     virtual void Print() const override {
-        G4cout << "TrackInformation: cumTr = " << fCumTr << G4endl;
+        G4cout << "TrackInformation: cumTr = " << fCumTr << ", boundary index = " << fBoundaryIndex << G4endl;
     }
 
 private:
     G4int fCumTr;
+    G4int fBoundaryIndex;
 };
 
 #endif
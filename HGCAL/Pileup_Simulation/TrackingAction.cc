@@ -2,13 +2,7 @@
 #include "TrackInformation.hh"
 #include "G4Track.hh"
 #include "G4TrackingManager.hh"
-#include "G4EventManager.hh"
-#include "G4Event.hh"
-#include <map>
-
-// Static variables
-static std::map<G4int, G4int> trackCumTrMap;
-static G4int lastEventID = -1;
+#include "ShowerLibrary.hh"
 
 MyTrackingAction::MyTrackingAction() {}
 
@@ -16,19 +10,9 @@ MyTrackingAction::~MyTrackingAction() {}
 
 void MyTrackingAction::PreUserTrackingAction(const G4Track* track)
 {
-    // Get current event ID
-    G4int currentEventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
-    
-    // Clear map if this is a new event
-    if (currentEventID != lastEventID) {
-        trackCumTrMap.clear();
-        lastEventID = currentEventID;
-    }
-    
-    G4Track* nonConstTrack = const_cast<G4Track*>(track);
-    
-    if (track->GetParentID() == 0) {
-        // This is a primary particle
+    // Primaries take cumTr from the generator; secondaries already carry
+    // their parent's (set in PostUserTrackingAction)
+    if (track->GetParentID() == 0 && !track->GetUserInformation()) {
         const G4DynamicParticle* dynamicParticle = track->GetDynamicParticle();
         if (dynamicParticle) {
             const G4PrimaryParticle* primaryParticle = dynamicParticle->GetPrimaryParticle();
@@ -42,27 +26,30 @@ void MyTrackingAction::PreUserTrackingAction(const G4Track* track)
                     if (ppInfo) {
                         G4int cumTr = ppInfo->GetCumTr();
                         
-                        nonConstTrack->SetUserInformation(new TrackInformation(cumTr));
-                        trackCumTrMap[track->GetTrackID()] = cumTr;
+                        const_cast<G4Track*>(track)->SetUserInformation(new TrackInformation(cumTr));
                     }
                 }
             }
         }
-    } else {
-        // Secondary particle - inherit from parent
-        G4int parentID = track->GetParentID();
-        
-        auto it = trackCumTrMap.find(parentID);
-        if (it != trackCumTrMap.end()) {
-            G4int cumTr = it->second;
-            
-            nonConstTrack->SetUserInformation(new TrackInformation(cumTr));
-            trackCumTrMap[track->GetTrackID()] = cumTr;
-        }
+    }
+
+    if (ShowerLibrary::GetMode() == ShowerLibrary::kGenerate) {
+        ShowerLibraryRecorder::Instance().BeginTrack(track);
     }
 }
 
 void MyTrackingAction::PostUserTrackingAction(const G4Track* track)
 {
-    // Geant4 automatically manages TrackInformation memory
+    // Pass cumTr and the boundary index on to the secondaries of this track
+    // before they are stacked. Geant4 deletes the TrackInformation with each track.
+    const TrackInformation* info = static_cast<const TrackInformation*>(track->GetUserInformation());
+    if (!info) return;
+
+    G4TrackVector* secondaries = fpTrackingManager->GimmeSecondaries();
+    if (!secondaries) return;
+    for (G4Track* secondary : *secondaries) {
+        if (!secondary->GetUserInformation()) {
+            secondary->SetUserInformation(new TrackInformation(info->GetCumTr(), info->GetBoundaryIndex()));
+        }
+    }
 }
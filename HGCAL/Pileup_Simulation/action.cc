@@ -1,7 +1,10 @@
 #include "action.hh"
 #include "generator.hh"
 #include "run.hh"
+#include "event.hh"
 #include "TrackingAction.hh"  // ADD THIS
+#include "stepping.hh"
+#include "stacking.hh"
 
 // Constructor
 MyActionInitialization::MyActionInitialization() {}
@@ -9,17 +12,35 @@ MyActionInitialization::MyActionInitialization() {}
 // Destructor
 MyActionInitialization::~MyActionInitialization() {}
 
-// Build method
+// Master thread: only the run action, which merges the worker ntuples
+void MyActionInitialization::BuildForMaster() const {
+    MyRunAction* runAction = new MyRunAction();
+    SetUserAction(runAction);
+}
+
+// Build method (called once per worker thread, or once in sequential mode)
 void MyActionInitialization::Build() const {
+    // Run action for ROOT output (also owns the counters and tracking cuts)
+    MyRunAction* runAction = new MyRunAction();
+    SetUserAction(runAction);
+
     // Primary generator
-    MyPrimaryGenerator* generator = new MyPrimaryGenerator();
+    MyPrimaryGenerator* generator = new MyPrimaryGenerator(runAction);
     SetUserAction(generator);
 
-    // Run action for ROOT output
-    MyRunAction* runAction = new MyRunAction();
-    SetUserAction(runAction);
+    // Stacking action: kills useless tracks, releases primaries a few at a time
+    MyStackingAction* stackingAction = new MyStackingAction(runAction);
+    SetUserAction(stackingAction);
+
+    // Event action: writes the hits collections at the end of each event
+    MyEventAction* eventAction = new MyEventAction(stackingAction);
+    SetUserAction(eventAction);
     
     // Tracking action for cumTr inheritance (ADD THIS)
     MyTrackingAction* trackingAction = new MyTrackingAction();
     SetUserAction(trackingAction);
+
+    // Stepping action: time cut, and looper killer in the vacuum
+    MySteppingAction* steppingAction = new MySteppingAction(runAction);
+    SetUserAction(steppingAction);
 }
@@ -3,18 +3,42 @@
 
 #include "G4VUserDetectorConstruction.hh"
 #include "G4Material.hh"
+#include "G4LogicalVolume.hh"
+#include "G4GenericMessenger.hh"
+#include "LayerStack.hh"
 #include "globals.hh"
 #include <vector>
 
-// Structure to hold material layer information
-struct MaterialLayer {
-    G4String name;
-    G4Material* material;
-    G4double zMin;          // mm
-    G4double zMax;          // mm
-    G4double outerRadius;   // cm
-    G4double innerRadius;    // cm
-    G4int layerNumber;      // -1 for non-silicon layers
+// Silicon sensor plane, in z order (index = layer - 1)
+struct SiliconPlane {
+    G4int layer;
+    G4double zMin;
+    G4double zMax;
+    G4double innerRadius;
+    G4double outerRadius;
+};
+
+// Mother volume of a range of layers; zCentre is its global z (the layers
+// are placed at their global z minus zCentre)
+struct LayerMother {
+    G4double zBegin;
+    G4double zEnd;
+    G4double zCentre;
+    G4LogicalVolume* logical;
+};
+
+// Placement of the layers (/hgcal/geometry/nesting)
+enum class GeometryNesting {
+    Flat,      // every layer directly in the world
+    Envelope,  // all layers in one endcap tube
+    Cassette   // endcap tube > cassette tubes (CE-E sensor pairs, CE-H single sensors) > layers
+};
+
+// Level of detail of the layer stack (/hgcal/geometry/fidelity)
+enum class GeometryFidelity {
+    Full,    // every layer of the composition table
+    Merged,  // one mixture slab per gap between sensors (same mass, X0 and lambda)
+    Toy      // silicon + lead toy model
 };
 
 class MyDetectorConstruction : public G4VUserDetectorConstruction {
@@ -24,6 +48,74 @@ public:
 
     virtual G4VPhysicalVolume* Construct();
     virtual void ConstructSDandField() override;
+
+    // Layout and stack options (/hgcal/geometry/); each rebuilds the
+    // geometry if it was already constructed
+    void SetNesting(const G4String& nesting);
+    void SetLayerFile(const G4String& fileName);
+    void SetRadiiFile(const G4String& fileName);
+    void SetGlue(G4bool enable);
+    void SetAir(G4bool enable);
+    void SetFidelity(const G4String& fidelity);
+
+    // Envelope of the layer stack, filled by Construct (read-only afterwards)
+    G4double GetFrontFaceZ() const { return fFrontFaceZ; }
+    G4double GetFrontInnerRadius() const { return fFrontInnerRadius; }
+    G4double GetFrontOuterRadius() const { return fFrontOuterRadius; }
+    G4double GetMinInnerRadius() const { return fMinInnerRadius; }
+    G4double GetFieldZ() const { return fFieldZ; }
+    const std::vector<SiliconPlane>& GetSiliconPlanes() const { return fSiliconPlanes; }
+
+    // CE-E section (silicon layers 1-26), summarised for the fast shower model
+    static const G4int kLastCEELayer = 26;
+    G4double GetCEEBackZ() const { return fCEEBackZ; }
+    G4double GetCEEInnerRadius() const { return fCEEInnerRadius; }
+    G4double GetCEEOuterRadius() const { return fCEEOuterRadius; }
+    G4Material* GetCEEPassiveMaterial() const { return fCEEPassive; }
+    G4double GetCEEPassiveThickness() const { return fCEEPassiveThickness; }
+    G4double GetCEEActiveThickness() const { return fCEEActiveThickness; }
+    G4double GetCEESiliconWeight() const { return fCEESiliconWeight; }
+
+private:
+    G4GenericMessenger* fMessenger;
+    GeometryNesting fNesting;
+    GeometryFidelity fFidelity;
+    G4bool fConstructed;
+
+    G4String fLayerFile;
+    G4String fRadiiFile;
+    G4bool fWithGlue;
+    G4bool fWithAir;
+
+    // Materials, created on first use and kept across rebuilds
+    MaterialCache fMaterials;
+
+    // Silicon logical volumes; the sensitive detector is attached per thread
+    std::vector<G4LogicalVolume*> fSiliconLogicals;
+    std::vector<SiliconPlane> fSiliconPlanes;
+
+    G4double fFrontFaceZ;        // upstream face of the first layer
+    G4double fFrontInnerRadius;  // radii of the first layer
+    G4double fFrontOuterRadius;
+    G4double fMinInnerRadius;    // smallest inner radius of any layer
+    G4double fFieldZ;            // uniform solenoid field along z
+
+    G4double fCEEBackZ;             // downstream face of the last CE-E sensor
+    G4double fCEEInnerRadius;
+    G4double fCEEOuterRadius;
+    G4Material* fCEEPassive;        // all passive CE-E layers mixed by mass
+    G4double fCEEPassiveThickness;  // passive and silicon thickness per sampling cell
+    G4double fCEEActiveThickness;
+    G4double fCEESiliconWeight;     // visible / geometric silicon fraction (mip estimate)
+
+    void GeometryChanged();
+    // Places the mother volumes of the current nesting, in z order; a layer
+    // goes into the mother whose z range holds its centre
+    std::vector<LayerMother> BuildMothers(G4LogicalVolume* logicWorld,
+                                          const std::vector<MaterialLayer>& siliconLayers,
+                                          const std::vector<MaterialLayer>& nonSiliconLayers);
+    void ComputeCEESummary(const std::vector<MaterialLayer>& siliconLayers,
+                           const std::vector<MaterialLayer>& nonSiliconLayers);
 };
 
 #endif
@@ -2,47 +2,99 @@
 #define DETECTOR_HH
 
 #include "G4VSensitiveDetector.hh"
+#include "G4VGFlashSensitiveDetector.hh"
 #include "G4ThreeVector.hh"
-#include <map>
-#include <string>
-
-struct ParticleData {
-    G4int eventID;
-    G4int trackID;
-    G4int layer;
-    G4int particleID;
-    G4int cumTr;  
-    G4double charge;
-    G4double energyBefore;
-    G4double energyAfter;
-    G4double totalEnergyDeposited;
-    G4ThreeVector momentumBefore;
-    G4ThreeVector momentumAfter;
-    G4ThreeVector positionEnter;
-    G4ThreeVector positionExit;
-    G4double etaEnter;
-    G4double phiEnter;
-    G4double etaExit;
-    G4double phiExit;
-    
-    ParticleData() : eventID(0), trackID(0), layer(0), particleID(0), cumTr(-1),
-                     charge(0.0), energyBefore(0.0), energyAfter(0.0), 
-                     totalEnergyDeposited(0.0),
-                     etaEnter(0.0), phiEnter(0.0), etaExit(0.0), phiExit(0.0) {}
+#include "G4GenericMessenger.hh"
+#include "HitMap.hh"
+#include "HexCellGeometry.hh"
+#include "hit.hh"
+#include "PremixLibrary.hh"
+#include <cstdint>
+
+// Granularity of the track hits produced by the sensitive detector
+enum class HitGranularity {
+    Step,      // one hit per step (legacy output)
+    Crossing,  // one hit per track per layer crossing (default)
+    Cell       // one hit per track per layer per hexagonal cell, summed over the event
 };
 
-class MySensitiveDetector : public G4VSensitiveDetector {
+// Accumulates silicon deposits into two hits collections, written out by
+// MyEventAction at the end of the event:
+//   "TrackHits": MyHit per track and layer (ParticleTracking ntuple)
+//   "CellHits":  MyCellHit per hexagonal cell (CellHits ntuple)
+//   "CellTruth": MyCellTruthHit per cell and boundary particle, with boundary
+//                truth on (CellTruth ntuple)
+// Deposits of parameterised showers (GFlash, shower library) are filled into
+// the same records, attributed to the particle that started the shower.
+// Deposits outside the hit-time window (/hgcal/sd/timeWindow) are dropped.
+// Premixing (PremixLibrary): the cells of each event are stored as a library
+// event, or Poisson(mu) library events are added to them before they are stored.
+class MySensitiveDetector : public G4VSensitiveDetector, public G4VGFlashSensitiveDetector {
 public:
     MySensitiveDetector(const G4String& name);
     virtual ~MySensitiveDetector();
     
     virtual void Initialize(G4HCofThisEvent* hce) override;
     virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
+    virtual G4bool ProcessHits(G4GFlashSpot* spot, G4TouchableHistory* history) override;
     virtual void EndOfEvent(G4HCofThisEvent* hce) override;
 
+    void SetGranularity(const G4String& granularity);
+    void SetCellHits(G4bool enable) { fWriteCellHits = enable; }
+    void SetGFlashWeight(G4double weight) { fGFlashWeight = weight; }
+
+    // Deposit from a fast-simulation model (GFlash spot, shower library),
+    // filled into the track and cell records of the originating particle
+    void AddParameterisedDeposit(const G4Track* track, G4int layer, const G4ThreeVector& position,
+                                 G4double edep, G4double time, G4double z);
+
 private:
-    std::map<std::string, ParticleData> fParticleData;
-    void WriteParticleData(const ParticleData& data);
+    // Open records keyed by packed (trackID, layer, cell); storage reused across events
+    FlatHitMap<MyHit> fOpenHits;
+    // Per-cell energy of the current event, keyed by detector ID
+    FlatHitMap<MyCellHit> fCellData;
+    // Per-cell energy by boundary particle, keyed by detector ID | boundary index
+    FlatHitMap<MyCellTruthHit> fCellTruthData;
+    // Cells of the event in premix production mode (storage reused)
+    std::vector<PremixCell> fPremixCells;
+
+    MyHitsCollection* fTrackHits;
+    MyCellHitsCollection* fCellHits;
+    MyCellTruthHitsCollection* fCellTruthHits;
+    G4int fTrackHitsID;
+    G4int fCellHitsID;
+    G4int fCellTruthHitsID;
+
+    G4bool fWriteCellHits;
+    HitGranularity fGranularity;
+    G4double fGFlashWeight;  // scale of GFlash spot energies landing in silicon
+    G4double fTimeWindow;    // deposits later than this are not read out (<= 0: no window)
+    G4GenericMessenger* fMessenger;
+
+    // Key layout: trackID (32 bits) | layer (8 bits) | cell (24 bits)
+    static std::uint64_t MakeHitKey(G4int trackID, G4int layer, std::uint32_t cell = 0) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(trackID)) << 32)
+             | (static_cast<std::uint64_t>(layer & 0xff) << 24)
+             | (cell & 0xffffff);
+    }
+
+    // 24-bit cell index: wafer u, v (7 bits each, offset by 64) | cell u, v (5 bits each)
+    static std::uint32_t HexCellIndex(const HexCell& cell) {
+        return (static_cast<std::uint32_t>((cell.waferU + 64) & 0x7f) << 17)
+             | (static_cast<std::uint32_t>((cell.waferV + 64) & 0x7f) << 10)
+             | (static_cast<std::uint32_t>(cell.cellU & 0x1f) << 5)
+             | static_cast<std::uint32_t>(cell.cellV & 0x1f);
+    }
+
+    // Sum a deposit into the cell record of the current event
+    void AddCellDeposit(std::uint32_t detId, G4double edep, G4double time, G4double z, G4int boundaryIndex);
+
+    // Premixing, at the end of the event
+    void StorePremixEvent();
+    void OverlayPileup();
+
+    // Move a finished record into the hits collection
+    void StoreHit(const MyHit& hit);
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef EVENT_HH
+#define EVENT_HH
+
+#include "G4UserEventAction.hh"
+#include "G4Event.hh"
+#include "hit.hh"
+#include "AsyncOutput.hh"
+#include "BoundaryTruth.hh"
+#include <memory>
+
+class MyStackingAction;
+
+// Writes the hits collections of the sensitive detector to the ntuples,
+// in one batch at the end of each event, or hands them to AsyncOutput
+class MyEventAction : public G4UserEventAction {
+public:
+    MyEventAction(MyStackingAction* stackingAction = nullptr);
+    ~MyEventAction();
+
+    virtual void BeginOfEventAction(const G4Event*) override;
+    virtual void EndOfEventAction(const G4Event*) override;
+
+    // Forget which cells were exported to the CellGeometry table (new output file)
+    static void ResetCellGeometry();
+
+private:
+    MyStackingAction* fStackingAction;  // per-event stack report, if any
+    G4int fTrackHitsID;
+    G4int fCellHitsID;
+    G4int fCellTruthHitsID;
+
+    // Double buffer towards the asynchronous writer (created on first use)
+    std::unique_ptr<AsyncOutputProducer> fProducer;
+
+    void WriteTrackHit(G4int eventID, const MyHit& hit);
+    void WriteCellHit(G4int eventID, const MyCellHit& hit);
+    void WriteCellGeometry(const MyCellHit& hit);
+    void WriteBoundaryParticle(G4int eventID, G4int index, const BoundaryParticle& particle);
+    void WriteCellTruth(G4int eventID, const MyCellTruthHit& hit);
+};
+
+#endif
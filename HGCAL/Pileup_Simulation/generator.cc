@@ -1,5 +1,9 @@
 #include "generator.hh"           // MUST BE FIRST - includes class definition
 #include "TrackInformation.hh"  
+#include "HelixPropagator.hh"
+#include "construction.hh"
+#include "G4RunManager.hh"
+#include "run.hh"
 #include "G4Event.hh"
 #include "G4PrimaryVertex.hh"
 #include "G4PrimaryParticle.hh"
@@ -9,14 +13,28 @@
 #include "G4SystemOfUnits.hh"
 #include "G4AnalysisManager.hh"
 #include "Randomize.hh"
+#include "G4AutoLock.hh"
+#include "G4Poisson.hh"
+#include <algorithm>
 #include <cmath>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 
-MyPrimaryGenerator::MyPrimaryGenerator() : fCurrentIndex(0) {
-    fParticleGun = new G4ParticleGun(1);
-    
+namespace {
+    G4Mutex particleDataMutex = G4MUTEX_INITIALIZER;
+}
+
+ParticleFileReader MyPrimaryGenerator::fReader;
+ParticleFileReader MyPrimaryGenerator::fPoolReader;
+G4int MyPrimaryGenerator::fPoolFirstEvent = 0;
+G4int MyPrimaryGenerator::fPoolLastEvent = -1;
+
+MyPrimaryGenerator::MyPrimaryGenerator(MyRunAction* runAction)
+    : fRunAction(runAction), fCurrentIndex(0), fFileName("generated_data.txt"), fFirstEvent(0),
+      fPropagateToFront(false), fMix(false), fSignal("file"), fPoolFileName("minbias.txt"),
+      fMeanPileup(200.), fVertexSigmaZ(5. * cm), fGunParticle("gamma"), fGunPt(200. * GeV), fGunEta(1.95),
+      fFilter(false), fEtaMin(1.3), fEtaMax(3.2), fPtMin(0.),
+      fGeometryRunID(-1), fInjectionZ(0.),
+      fFrontInnerRadius(0.), fFrontOuterRadius(0.), fMinInnerRadius(0.), fFieldZ(0.) {
     // Print random engine information
     CLHEP::HepRandomEngine* engine = CLHEP::HepRandom::getTheEngine();
     G4cout << "========================================" << G4endl;
@@ -24,115 +42,221 @@ MyPrimaryGenerator::MyPrimaryGenerator() : fCurrentIndex(0) {
     G4cout << "Engine name: " << engine->name() << G4endl;
     G4cout << "========================================" << G4endl;
     
-    // Read the particle file
-    ReadParticleFile("generated_data.txt");  
+    // Input file settings (the file itself is opened on the first event)
+    fMessenger = new G4GenericMessenger(this, "/hgcal/generator/", "Pileup generator control");
+    fMessenger->DeclareProperty("file", fFileName, "Particle input file (text or binary, detected automatically)");
+    fMessenger->DeclareProperty("firstEvent", fFirstEvent,
+                                "Evt# of the input file that is simulated as event 0");
+    fMessenger->DeclareProperty("propagateToFront", fPropagateToFront,
+                                "Transport primaries analytically through the vacuum to the HGCAL front face");
+
+    // Acceptance pre-filter (off by default)
+    fMessenger->DeclareProperty("filter", fFilter,
+                                "Drop primaries outside the eta window, below ptMin, or curling inside the bore");
+    fMessenger->DeclareProperty("etaMin", fEtaMin, "Lower edge of the accepted |eta| window");
+    fMessenger->DeclareProperty("etaMax", fEtaMax, "Upper edge of the accepted |eta| window");
+    fMessenger->DeclarePropertyWithUnit("ptMin", "GeV", fPtMin, "Minimum primary pT");
+
+    // Pileup mixing (replay by default)
+    fMessenger->DeclareMethod("mode", &MyPrimaryGenerator::SetMode,
+                              "replay: events of the particle file as they are; mix: signal + Poisson(mu) pool events")
+        .SetCandidates("replay mix");
+    fMessenger->DeclareProperty("signal", fSignal, "Signal of a mixed event: file (event of /hgcal/generator/file), gun or none")
+        .SetCandidates("file gun none");
+    fMessenger->DeclareProperty("minBiasFile", fPoolFileName,
+                                "Minimum-bias pool (text or binary particle file, one interaction per Evt#)");
+    fMessenger->DeclareProperty("mu", fMeanPileup, "Mean number of pileup interactions per mixed event");
+    fMessenger->DeclarePropertyWithUnit("vertexSigmaZ", "cm", fVertexSigmaZ,
+                                        "Gaussian spread of the vertex z of each mixed interaction (0: origin)");
+    fMessenger->DeclareProperty("gunParticle", fGunParticle, "Signal gun particle");
+    fMessenger->DeclarePropertyWithUnit("gunPt", "GeV", fGunPt, "Signal gun pT");
+    fMessenger->DeclareProperty("gunEta", fGunEta, "Signal gun |eta| (phi is random)");
 }
 
 MyPrimaryGenerator::~MyPrimaryGenerator() {
-    delete fParticleGun;
+    delete fMessenger;
 }
 
-void MyPrimaryGenerator::ReadParticleFile(const G4String& filename) {
-    G4cout << "======================================" << G4endl;
-    G4cout << "Attempting to open file: " << filename << G4endl;
-    
-    std::ifstream infile(filename);
-    if (!infile.is_open()) {
-        G4cout << "ERROR: Cannot open particle file: " << filename << G4endl;
-        return;
+G4bool MyPrimaryGenerator::OpenParticleFile() {
+    G4AutoLock lock(&particleDataMutex);
+    if (fReader.IsOpen() && fReader.GetFileName() == fFileName) return true;
+    return fReader.Open(fFileName);
+}
+
+void MyPrimaryGenerator::SetMode(const G4String& mode) {
+    fMix = (mode == "mix");
+}
+
+G4bool MyPrimaryGenerator::OpenPoolFile() {
+    G4AutoLock lock(&particleDataMutex);
+    if (fPoolReader.IsOpen() && fPoolReader.GetFileName() == fPoolFileName) return true;
+    if (!fPoolReader.Open(fPoolFileName)) return false;
+    if (!fPoolReader.GetEventRange(fPoolFirstEvent, fPoolLastEvent)) {
+        G4cout << "ERROR: Minimum-bias pool has no events: " << fPoolFileName << G4endl;
+        fPoolReader.Close();
+        return false;
     }
-    
-    G4cout << "File opened successfully!" << G4endl;
-    
-    std::string line;
-    // Skip header line
-    if (!std::getline(infile, line)) {
-        G4cout << "ERROR: Cannot read header line!" << G4endl;
-        return;
+    G4cout << "Minimum-bias pool " << fPoolFileName << ": Evt# " << fPoolFirstEvent << " - " << fPoolLastEvent << G4endl;
+    return true;
+}
+
+void MyPrimaryGenerator::CacheGeometry() {
+    const MyDetectorConstruction* detector = static_cast<const MyDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+    // Inject just upstream of the first layer, so the first step starts in vacuum
+    const G4double injectionGap = 1.0 * mm;
+    fInjectionZ = detector->GetFrontFaceZ() - injectionGap;
+    fFrontInnerRadius = detector->GetFrontInnerRadius();
+    fFrontOuterRadius = detector->GetFrontOuterRadius();
+    fMinInnerRadius = detector->GetMinInnerRadius();
+    fFieldZ = detector->GetFieldZ();
+    fGeometryRunID = fRunAction->GetRunID();
+}
+
+G4ParticleDefinition* MyPrimaryGenerator::FindDefinition(G4int pdgID) {
+    auto it = fDefinitions.find(pdgID);
+    if (it != fDefinitions.end()) return it->second;
+    G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(pdgID);
+    if (!particle) {
+        G4cout << "WARNING: Unknown PDG ID " << pdgID << ", skipping its particles" << G4endl;
     }
-    G4cout << "Header: " << line << G4endl;
-    
-    int lineCount = 0;
-    while (std::getline(infile, line)) {
-        lineCount++;
-        std::istringstream iss(line);
-        ParticleGenInfo particle;
-        
-        // Read 7 columns: Evt#, Cum_Tr#, PDG_ID, Pt, Phi, Theta, Eta
-        if (iss >> particle.eventID >> particle.cumTr >> particle.pdgID 
-                >> particle.pt >> particle.phi >> particle.theta >> particle.eta) {
-            
-            // Skip particles with invalid values (inf, nan, zero pt)
-            if (std::isfinite(particle.eta) && std::isfinite(particle.pt) && 
-                std::isfinite(particle.phi) && std::isfinite(particle.theta) &&
-                particle.pt > 0.0) {
-                
-                fParticleData.push_back(particle);
-                if (lineCount <= 3) {
-                    G4cout << "Parsed line " << lineCount << ": Event=" << particle.eventID 
-                           << " CumTr=" << particle.cumTr 
-                           << " PDG=" << particle.pdgID
-                           << " pT=" << particle.pt 
-                           << " Phi=" << particle.phi 
-                           << " Theta=" << particle.theta
-                           << " Eta=" << particle.eta << G4endl;
-                }
-            } else {
-                if (lineCount <= 20) {  // Only show first 20 warnings
-                    G4cout << "WARNING: Skipping line " << lineCount << " with invalid values (inf/nan/zero): " 
-                           << line << G4endl;
-                }
-            }
-        } else {
-            if (lineCount <= 20) {  // Only show first 20 warnings
-                G4cout << "WARNING: Failed to parse line " << lineCount << ": " << line << G4endl;
-            }
+    fDefinitions.emplace(pdgID, particle);
+    return particle;
+}
+
+G4bool MyPrimaryGenerator::PassesFilter(G4double eta, G4double pT, G4double charge) {
+    if (eta < fEtaMin || eta > fEtaMax) {
+        fRunAction->CountFilteredEta();
+        return false;
+    }
+    // Charged particles need 2R >= r_inner to ever leave the bore
+    G4double maxRadius = HelixPropagator::MaxRadius(G4ThreeVector(pT, 0., 0.), charge, fFieldZ);
+    if (pT < fPtMin || maxRadius < fMinInnerRadius) {
+        fRunAction->CountFilteredPt();
+        return false;
+    }
+    return true;
+}
+
+G4bool MyPrimaryGenerator::ReadSignal(G4int eventID) {
+    if (fSignal == "gun") {
+        // One particle at fixed pT and |eta|, random phi
+        G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(fGunParticle);
+        if (!particle) {
+            G4cout << "ERROR: Unknown signal gun particle " << fGunParticle << G4endl;
+            return false;
         }
+        G4double phi = (2.0 * G4UniformRand() - 1.0) * CLHEP::pi;
+        G4double theta = 2.0 * std::atan(std::exp(-fGunEta));
+        fEventParticles.assign(1, {eventID, 0, particle->GetPDGEncoding(), fGunPt / GeV, phi, theta, fGunEta});
+        return true;
     }
-    
-    infile.close();
-    G4cout << "Loaded " << fParticleData.size() << " particles from " << filename << G4endl;
-    G4cout << "Using eta and pT values from file" << G4endl;
-    G4cout << "======================================" << G4endl;
+    if (fSignal == "file") {
+        if (!OpenParticleFile()) return false;
+        return fReader.ReadEvent(eventID + fFirstEvent, fEventParticles) && !fEventParticles.empty();
+    }
+    fEventParticles.clear();
+    return false;
 }
 
-void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
-    if (fParticleData.empty()) {
-        G4cout << "ERROR: No particle data available!" << G4endl;
-        return;
+G4bool MyPrimaryGenerator::DrawPoolEvent() {
+    // Evt# may have gaps (events without valid particles): draw again
+    const G4int maxTries = 100;
+    G4int nEvents = fPoolLastEvent - fPoolFirstEvent + 1;
+    for (G4int tries = 0; tries < maxTries; ++tries) {
+        G4int poolEvent = fPoolFirstEvent + std::min(static_cast<G4int>(G4UniformRand() * nEvents), nEvents - 1);
+        if (fPoolReader.ReadEvent(poolEvent, fEventParticles) && !fEventParticles.empty()) return true;
     }
-    
+    return false;
+}
+
+void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
     G4int eventID = anEvent->GetEventID();
-    G4AnalysisManager* man = G4AnalysisManager::Instance();
-    G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
     
     // Get seed and generate random number for this event
     long seed = CLHEP::HepRandom::getTheSeed();
     long randomNumber = static_cast<long>(G4UniformRand() * 1e12);
     
-    // Find all particles for this event
-    std::vector<ParticleGenInfo> eventParticles;
-    for (const auto& particle : fParticleData) {
-        if (particle.eventID == eventID) {
-            eventParticles.push_back(particle);
+    if ((fPropagateToFront || fFilter) && fGeometryRunID != fRunAction->GetRunID()) {
+        CacheGeometry();
+    }
+    InjectionCounts counts;
+    G4int nGenerated = 0;
+    G4int nPileup = 0;
+
+    if (!fMix) {
+        if (!OpenParticleFile()) {
+            G4cout << "ERROR: No particle data available!" << G4endl;
+            return;
+        }
+        // Decode only this event's particles from the mapped file
+        if (!fReader.ReadEvent(eventID + fFirstEvent, fEventParticles) || fEventParticles.empty()) {
+            G4cout << "WARNING: No particles found for event " << eventID + fFirstEvent << G4endl;
+            return;
+        }
+        nGenerated = static_cast<G4int>(fEventParticles.size());
+        AddInteraction(anEvent, 0, 0.0, 0, seed, randomNumber, counts);
+    } else {
+        if (!OpenPoolFile()) {
+            G4cout << "ERROR: No minimum-bias pool available!" << G4endl;
+            return;
+        }
+        // Signal first (interaction 0), then the pileup interactions, each
+        // with cumTr shifted past those already in the event
+        G4int nextCumTr = 0;
+        if (ReadSignal(eventID)) {
+            nGenerated += static_cast<G4int>(fEventParticles.size());
+            G4double vertexZ = fVertexSigmaZ > 0. ? G4RandGauss::shoot(0., fVertexSigmaZ) : 0.;
+            nextCumTr = AddInteraction(anEvent, 0, vertexZ, 0, seed, randomNumber, counts) + 1;
+        } else if (fSignal != "none") {
+            G4cout << "WARNING: No signal for event " << eventID << G4endl;
+        }
+        nPileup = static_cast<G4int>(G4Poisson(fMeanPileup));
+        for (G4int interaction = 1; interaction <= nPileup; ++interaction) {
+            if (!DrawPoolEvent()) {
+                G4cout << "WARNING: No particles drawn from the minimum-bias pool" << G4endl;
+                break;
+            }
+            G4int minCumTr = fEventParticles.front().cumTr;
+            for (const ParticleGenInfo& genInfo : fEventParticles) minCumTr = std::min(minCumTr, genInfo.cumTr);
+            nGenerated += static_cast<G4int>(fEventParticles.size());
+            G4double vertexZ = fVertexSigmaZ > 0. ? G4RandGauss::shoot(0., fVertexSigmaZ) : 0.;
+            nextCumTr = AddInteraction(anEvent, interaction, vertexZ, nextCumTr - minCumTr,
+                                       seed, randomNumber, counts) + 1;
         }
     }
+    fRunAction->CountGenerated(nGenerated);
     
-    if (eventParticles.empty()) {
-        G4cout << "WARNING: No particles found for event " << eventID << G4endl;
-        return;
+    G4cout << "Event " << eventID << ": Generated " << nGenerated - counts.dropped - counts.filtered << " particles";
+    if (fMix) {
+        G4cout << " (signal + " << nPileup << " pileup interactions)";
     }
-    
-    G4cout << "Event " << eventID << ": Generating " << eventParticles.size() << " particles" << G4endl;
-    
-    // Generate all particles for this event
-    for (const auto& genInfo : eventParticles) {
+    if (fFilter) {
+        G4cout << " (" << counts.filtered << " outside acceptance)";
+    }
+    if (fPropagateToFront) {
+        G4cout << " (" << counts.propagated << " injected at the front face, " << counts.dropped << " dropped)";
+    }
+    G4cout << G4endl;
+}
+
+G4int MyPrimaryGenerator::AddInteraction(G4Event* event, G4int interaction, G4double vertexZ, G4int cumTrOffset,
+                                         long seed, long randomNumber, InjectionCounts& counts) {
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    G4int eventID = event->GetEventID();
+    G4int maxCumTr = cumTrOffset - 1;
+
+    // Shared by the primaries that start at the interaction point (created with the first)
+    G4PrimaryVertex* interactionVertex = nullptr;
+
+    for (const ParticleGenInfo& genInfo : fEventParticles) {
+        G4int cumTr = genInfo.cumTr + cumTrOffset;
+        maxCumTr = std::max(maxCumTr, cumTr);
+
         // Get particle definition from file
-        G4ParticleDefinition* particle = particleTable->FindParticle(genInfo.pdgID);
-        if (!particle) {
-            G4cout << "WARNING: Unknown PDG ID " << genInfo.pdgID << ", skipping..." << G4endl;
-            continue;
-        }
+        G4ParticleDefinition* particle = FindDefinition(genInfo.pdgID);
+        if (!particle) continue;
         
         // ==========================================
         // VALUES FROM FILE
@@ -154,10 +278,10 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
         G4double pz = pT * std::sinh(eta);  // pz = pT * sinh(eta)
         G4double pTot = std::sqrt(px*px + py*py + pz*pz);
         
-        // Position: FIXED at origin
+        // Position: on the beam line, at the vertex of the interaction
         G4double x = 0.0 * cm;
         G4double y = 0.0 * cm;
-        G4double z = 0.0 * cm;
+        G4double z = vertexZ;
         
         // Calculate energy (E = sqrt(p^2 + m^2))
         G4double mass = particle->GetPDGMass();
@@ -166,27 +290,56 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
         // Get particle charge
         G4double charge = particle->GetPDGCharge() / CLHEP::eplus;  // Convert to units of e
         
-        // Configure particle gun
-        fParticleGun->SetParticleDefinition(particle);
-        fParticleGun->SetParticlePosition(G4ThreeVector(x, y, z));
-        fParticleGun->SetParticleMomentumDirection(G4ThreeVector(px, py, pz).unit());
-        fParticleGun->SetParticleMomentum(pTot);
-        
-        // Fire the particle
-        fParticleGun->GeneratePrimaryVertex(anEvent);
+        // Optional acceptance pre-filter, then optional analytic transport
+        // through the vacuum to the front face. Particles that can never reach
+        // the annulus are dropped (truth row only); those that miss it at the
+        // front plane start from the origin.
+        G4ThreeVector position(x, y, z);
+        G4ThreeVector momentum(px, py, pz);
+        G4double time = 0.0;
+        G4bool dropped = false;
+        G4bool atVertex = true;
+        if (fFilter && !PassesFilter(eta, pT, charge)) {
+            dropped = true;
+            counts.filtered++;
+        } else if (fPropagateToFront) {
+            // The field is uniform along z: propagate from the origin over the
+            // same distance and shift by the vertex
+            HelixState state;
+            if (!HelixPropagator::PropagateToPlane(momentum, charge, mass, fFieldZ, fInjectionZ - z, state) ||
+                HelixPropagator::MaxRadius(momentum, charge, fFieldZ) < fMinInnerRadius) {
+                dropped = true;
+                counts.dropped++;
+                fRunAction->CountDropped();
+            } else {
+                G4double r = state.position.perp();
+                if (r >= fFrontInnerRadius && r <= fFrontOuterRadius) {
+                    position = state.position + G4ThreeVector(0., 0., z);
+                    momentum = state.momentum;
+                    time = state.time;
+                    atVertex = false;
+                    counts.propagated++;
+                }
+            }
+        }
         
-        // **KEY STEP: Attach cumTr to the primary particle**
-        // Get the vertex that was just created
-        G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex(anEvent->GetNumberOfPrimaryVertex() - 1);
-        if (vertex) {
-            G4PrimaryParticle* primary = vertex->GetPrimary();
-            if (primary) {
-                // Use PrimaryParticleInformation (not TrackInformation)
-                primary->SetUserInformation(new PrimaryParticleInformation(genInfo.cumTr));
+        if (!dropped) {
+            G4PrimaryVertex* vertex = interactionVertex;
+            if (!atVertex || !vertex) {
+                vertex = new G4PrimaryVertex(position, time);
+                event->AddPrimaryVertex(vertex);
+                if (atVertex) interactionVertex = vertex;
             }
+
+            // **KEY STEP: Attach cumTr to the primary particle**
+            // Use PrimaryParticleInformation (not TrackInformation)
+            G4PrimaryParticle* primary = new G4PrimaryParticle(particle, momentum.x(), momentum.y(), momentum.z());
+            primary->SetUserInformation(new PrimaryParticleInformation(cumTr));
+            vertex->SetPrimary(primary);
         }
         
         // Store generator-level information in ntuple 0
+        // (original vertex kinematics, also for propagated or dropped particles)
         man->FillNtupleIColumn(0, 0, eventID);
         man->FillNtupleIColumn(0, 1, genInfo.pdgID);         // PDG ID from file
         man->FillNtupleDColumn(0, 2, px / MeV);
@@ -197,7 +350,7 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
         man->FillNtupleDColumn(0, 7, eta);                   // eta from file
         man->FillNtupleDColumn(0, 8, phi);                   // phi from file (in radians)
         man->FillNtupleDColumn(0, 9, theta);                 // Calculated from eta
-        man->FillNtupleIColumn(0, 10, genInfo.cumTr);        // Cum_Tr# from file
+        man->FillNtupleIColumn(0, 10, cumTr);                // Cum_Tr# from file (+ interaction offset)
         man->FillNtupleDColumn(0, 11, pT / MeV);             // pT from file
         man->FillNtupleDColumn(0, 12, charge);               // charge from particle definition
         man->FillNtupleIColumn(0, 13, 0);                    // layer (0 for vertex)
@@ -206,7 +359,10 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent) {
         man->FillNtupleDColumn(0, 16, 0.0);                  // yi (not available, set to 0)
         man->FillNtupleIColumn(0, 17, static_cast<G4int>(seed));           // seed
         man->FillNtupleDColumn(0, 18, static_cast<G4double>(randomNumber)); // random number
+        man->FillNtupleIColumn(0, 19, interaction);          // 0: signal (or replayed event)
+        man->FillNtupleDColumn(0, 20, vertexZ / mm);
 
         man->AddNtupleRow(0);
     }
+    return maxCumTr;
 }
@@ -2,36 +2,97 @@
 #define GENERATOR_HH
 
 #include "G4VUserPrimaryGeneratorAction.hh"
-#include "G4ParticleGun.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4GenericMessenger.hh"
+#include "ParticleFileReader.hh"
+#include <unordered_map>
 #include <vector>
 
-// Structure to hold particle generation information from file
-struct ParticleGenInfo {
-    G4int eventID;      // Evt#
-    G4int cumTr;        // Cum_Tr#
-    G4int pdgID;        // PDG_ID
-    G4double pt;        // Pt
-    G4double phi;       // Phi
-    G4double theta;     // Theta
-    G4double eta;       // Eta
-};
+class MyRunAction;
 
+// Primaries from a particle file, in one of two modes (/hgcal/generator/mode):
+//   replay: every event of the file, as pre-mixed (default)
+//   mix:    a signal interaction (file event, particle gun or none) plus
+//           Poisson(mu) minimum-bias interactions drawn from a pool file,
+//           each at its own Gaussian vertex z, with cumTr offset so that it
+//           stays unique within the event
+// Primaries starting at the interaction point share one G4PrimaryVertex per
+// interaction; those injected at the front face get their own.
 class MyPrimaryGenerator : public G4VUserPrimaryGeneratorAction {
 public:
-    MyPrimaryGenerator();
+    MyPrimaryGenerator(MyRunAction* runAction);
     virtual ~MyPrimaryGenerator();
     
     virtual void GeneratePrimaries(G4Event* anEvent);
     
 private:
-    G4ParticleGun* fParticleGun;
-    std::vector<ParticleGenInfo> fParticleData;
+    MyRunAction* fRunAction;
     G4int fCurrentIndex;
-    
-    void ReadParticleFile(const G4String& filename);
+    G4GenericMessenger* fMessenger;
+
+    G4String fFileName;        // particle file (default: generated_data.txt)
+    G4int fFirstEvent;         // Evt# of the file served as Geant4 event 0
+    G4bool fPropagateToFront;  // inject primaries at the HGCAL front face
+
+    // Pileup mixing
+    G4bool fMix;
+    G4String fSignal;          // file, gun or none
+    G4String fPoolFileName;    // minimum-bias pool
+    G4double fMeanPileup;
+    G4double fVertexSigmaZ;
+    G4String fGunParticle;
+    G4double fGunPt;
+    G4double fGunEta;
+
+    // Acceptance pre-filter
+    G4bool fFilter;
+    G4double fEtaMin;
+    G4double fEtaMax;
+    G4double fPtMin;
+
+    // Stack envelope and field, re-read from the detector construction each run
+    G4int fGeometryRunID;  // run the values below were read in
+    G4double fInjectionZ;
+    G4double fFrontInnerRadius;
+    G4double fFrontOuterRadius;
+    G4double fMinInnerRadius;
+    G4double fFieldZ;
+
+    // Per-thread decode buffer, reused from event to event
+    std::vector<ParticleGenInfo> fEventParticles;
+    // Per-thread particle definitions by PDG ID (nullptr: unknown)
+    std::unordered_map<G4int, G4ParticleDefinition*> fDefinitions;
+
+    // Memory-mapped particle file and minimum-bias pool, shared by all worker threads
+    static ParticleFileReader fReader;
+    static ParticleFileReader fPoolReader;
+    static G4int fPoolFirstEvent;
+    static G4int fPoolLastEvent;
+
+    // Per event: how primaries were injected
+    struct InjectionCounts {
+        G4int propagated = 0;
+        G4int dropped = 0;
+        G4int filtered = 0;
+    };
+
+    void SetMode(const G4String& mode);
+    G4bool OpenParticleFile();
+    G4bool OpenPoolFile();
+    void CacheGeometry();
+    G4bool PassesFilter(G4double eta, G4double pT, G4double charge);
+    G4ParticleDefinition* FindDefinition(G4int pdgID);
+
+    // Signal of a mixed event into fEventParticles; false if it has none
+    G4bool ReadSignal(G4int eventID);
+    // Random pool event into fEventParticles
+    G4bool DrawPoolEvent();
+    // Primaries and GeneratorInfo rows of one interaction; returns the
+    // largest cumTr used (cumTr of the input + cumTrOffset)
+    G4int AddInteraction(G4Event* event, G4int interaction, G4double vertexZ, G4int cumTrOffset,
+                         long seed, long randomNumber, InjectionCounts& counts);
 };
 
 #endif
\ No newline at end of file
@@ -1,9 +1,112 @@
 #include "run.hh"
 #include "G4AnalysisManager.hh"
+#include "event.hh"
+#include "AsyncOutput.hh"
+#include "ShowerLibrary.hh"
+#include "BoundaryTruth.hh"
+#include "PremixLibrary.hh"
+#include "G4AccumulableManager.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ParticleDefinition.hh"
+#include <iomanip>
 #include <sstream>
+#include <sys/resource.h>
+
+namespace {
+    const G4String kOutputFile = "Photon_Pt_200_Eta_195_Events_2K_PU_000_Set01_Step1.root";
+    // Hit-level ntuples when they are written by the asynchronous writer
+    const G4String kAsyncOutputFile = "Photon_Pt_200_Eta_195_Events_2K_PU_000_Set01_Step1_hits.root";
+
+    const char* const kLateSpeciesNames[MyRunAction::kNumLateSpecies] = {
+        "neutron", "gamma", "e+-", "proton", "nucleus", "other"
+    };
+}
+
+MyRunAction::MyRunAction()
+: fRunID(-1), fKillLoopers(false), fTimeCut(0.), fTimeCutMode("enforce"), fTimeCutMeasure(false),
+  fKillNeutrinos(false), fPrimariesPerStage(0), fStackVerbose(false),
+  fSteps(0.), fGenerated(0), fFilteredEta(0), fFilteredPt(0), fDropped(0),
+  fLoopersKilled(0), fBackwardKilled(0), fKilledEnergy(0.),
+  fNeutrinosKilled(0), fNeutrinoEnergy(0.), fStackEvents(0), fPeakStackSum(0.), fResidentSum(0.),
+  fLateTracks(kNumLateSpecies, G4Accumulable<G4int>(0)),
+  fLateEnergy(kNumLateSpecies, G4Accumulable<G4double>(0.)),
+  fLateSteps(kNumLateSpecies, G4Accumulable<G4double>(0.)),
+  fLateSeconds(kNumLateSpecies, G4Accumulable<G4double>(0.)) {
+    G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+    accumulableManager->RegisterAccumulable(fSteps);
+    accumulableManager->RegisterAccumulable(fGenerated);
+    accumulableManager->RegisterAccumulable(fFilteredEta);
+    accumulableManager->RegisterAccumulable(fFilteredPt);
+    accumulableManager->RegisterAccumulable(fDropped);
+    accumulableManager->RegisterAccumulable(fLoopersKilled);
+    accumulableManager->RegisterAccumulable(fBackwardKilled);
+    accumulableManager->RegisterAccumulable(fKilledEnergy);
+    accumulableManager->RegisterAccumulable(fNeutrinosKilled);
+    accumulableManager->RegisterAccumulable(fNeutrinoEnergy);
+    accumulableManager->RegisterAccumulable(fStackEvents);
+    accumulableManager->RegisterAccumulable(fPeakStackSum);
+    accumulableManager->RegisterAccumulable(fResidentSum);
+    for (G4int species = 0; species < kNumLateSpecies; ++species) {
+        accumulableManager->RegisterAccumulable(fLateTracks[species]);
+        accumulableManager->RegisterAccumulable(fLateEnergy[species]);
+        accumulableManager->RegisterAccumulable(fLateSteps[species]);
+        accumulableManager->RegisterAccumulable(fLateSeconds[species]);
+    }
+
+    fCutsMessenger = new G4GenericMessenger(this, "/hgcal/cuts/", "Tracking cuts");
+    fCutsMessenger->DeclareProperty("killLoopers", fKillLoopers,
+                                    "Kill tracks in the vacuum that can never reach the calorimeter");
+    fCutsMessenger->DeclareProperty("killNeutrinos", fKillNeutrinos,
+                                    "Kill neutrinos when they are stacked");
+    fCutsMessenger->DeclarePropertyWithUnit("timeCut", "ns", fTimeCut,
+                                            "Global time beyond which tracks are killed (0 disables)");
+    fCutsMessenger->DeclareMethod("timeCutMode", &MyRunAction::SetTimeCutMode,
+                                  "enforce: kill late tracks; measure: keep them and time what they cost")
+        .SetCandidates("enforce measure");
+
+    fStackMessenger = new G4GenericMessenger(this, "/hgcal/stack/", "Track stacking");
+    fStackMessenger->DeclareProperty("primariesPerStage", fPrimariesPerStage,
+                                     "Primaries tracked together, each with all its secondaries (0: all at once)");
+    fStackMessenger->DeclareProperty("verbose", fStackVerbose,
+                                     "Print the peak stack size and resident memory of every event");
+
+    fMessenger = new G4GenericMessenger(this, "/hgcal/output/", "Output control");
+    fMessenger->DeclareMethod("async", &MyRunAction::SetAsyncOutput,
+                              "Write hit-level ntuples from a dedicated writer thread into a separate file")
+        .SetDefaultValue("true");
+    fMessenger->DeclareMethod("asyncBuffers", &MyRunAction::SetAsyncBuffers,
+                              "Events each worker can hand to the writer before it waits (default 2)");
+    fMessenger->DeclareMethod("boundaryTruth", &MyRunAction::SetBoundaryTruth,
+                              "Record particles entering the calorimeter and each cell's energy share per particle")
+        .SetDefaultValue("true");
+
+    fLibraryMessenger = new G4GenericMessenger(this, "/hgcal/showerLibrary/", "Frozen shower library");
+    fLibraryMessenger->DeclareMethod("mode", &MyRunAction::SetShowerLibraryMode,
+                                     "off, generate (record showers of low-energy particles) or use (stamp them)")
+        .SetCandidates("off generate use");
+    fLibraryMessenger->DeclareMethod("file", &MyRunAction::SetShowerLibraryFile,
+                                     "Library file written in generate mode and memory-mapped in use mode");
+    fLibraryMessenger->DeclareMethod("maxPerBin", &MyRunAction::SetShowerLibraryMaxPerBin,
+                                     "Showers kept per bin in generate mode");
+
+    fPremixMessenger = new G4GenericMessenger(this, "/hgcal/premix/", "Digital pileup premixing");
+    fPremixMessenger->DeclareMethod("mode", &MyRunAction::SetPremixMode,
+                                    "off, produce (store the cells of every event) or overlay (add library events)")
+        .SetCandidates("off produce overlay");
+    fPremixMessenger->DeclareMethod("file", &MyRunAction::SetPremixFile,
+                                    "Library file written in produce mode and memory-mapped in overlay mode");
+    fPremixMessenger->DeclareMethod("mu", &MyRunAction::SetPremixMeanPileup,
+                                    "Mean number of library events overlaid per event (Poisson)");
 
-MyRunAction::MyRunAction() {
     G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    // In MT mode, merge the worker ntuples into a single output file
+    // (sequential runs have no workers and would only get a warning)
+    if (G4Threading::IsMultithreadedApplication()) {
+        man->SetNtupleMerging(true);
+    }
     
     // Ntuple 0: Generator-level (truth-level) information
     man->CreateNtuple("GeneratorInfo", "Generator Level Particle Data");
@@ -26,6 +129,8 @@ MyRunAction::MyRunAction() {
     man->CreateNtupleDColumn("yi"); // 16
     man->CreateNtupleIColumn("seed"); // 17
     man->CreateNtupleDColumn("random_number"); // 18
+    man->CreateNtupleIColumn("interaction"); // 19: 0 signal, >= 1 mixed pileup
+    man->CreateNtupleDColumn("vertex_z_mm"); // 20
     man->FinishNtuple(0);
     
     // Ntuple 1: Hit-level information (WITH cumTr, charge, AND eta/phi ADDED)
@@ -57,19 +162,287 @@ MyRunAction::MyRunAction() {
     man->CreateNtupleDColumn("phi_enter"); // 24
     man->CreateNtupleDColumn("eta_exit"); // 25
     man->CreateNtupleDColumn("phi_exit"); // 26
+    man->CreateNtupleIColumn("detid"); // 27: packed ID of the entry cell
     man->FinishNtuple(1);
+    
+    // Ntuple 2: Per-event energy in hexagonal silicon cells, keyed by packed detector ID
+    man->CreateNtuple("CellHits", "Hexagonal Cell-wise Hit Data");
+    man->CreateNtupleIColumn("event_id"); // 0
+    man->CreateNtupleIColumn("detid"); // 1
+    man->CreateNtupleFColumn("edep"); // 2
+    man->CreateNtupleFColumn("time_ns"); // 3
+    man->FinishNtuple(2);
+    
+    // Ntuple 3: Geometry lookup table, one row per cell seen in this file
+    man->CreateNtuple("CellGeometry", "Hexagonal Cell Geometry");
+    man->CreateNtupleIColumn("detid"); // 0
+    man->CreateNtupleIColumn("layer"); // 1
+    man->CreateNtupleIColumn("waferU"); // 2
+    man->CreateNtupleIColumn("waferV"); // 3
+    man->CreateNtupleIColumn("cellU"); // 4
+    man->CreateNtupleIColumn("cellV"); // 5
+    man->CreateNtupleIColumn("waferType"); // 6: 0 = HD, 1 = LD
+    man->CreateNtupleFColumn("xi"); // 7
+    man->CreateNtupleFColumn("yi"); // 8
+    man->CreateNtupleFColumn("zi"); // 9
+    man->CreateNtupleFColumn("theta"); // 10
+    man->CreateNtupleFColumn("phi"); // 11
+    man->CreateNtupleFColumn("eta"); // 12
+    man->FinishNtuple(3);
+
+    // Ntuple 4: particles entering the calorimeter (boundary truth)
+    man->CreateNtuple("BoundaryTruth", "Particles Entering the Calorimeter");
+    man->CreateNtupleIColumn("event_id"); // 0
+    man->CreateNtupleIColumn("boundary_index"); // 1
+    man->CreateNtupleIColumn("track_id"); // 2
+    man->CreateNtupleIColumn("particle_id"); // 3
+    man->CreateNtupleIColumn("cumTr"); // 4
+    man->CreateNtupleFColumn("energy_MeV"); // 5: kinetic, at the boundary
+    man->CreateNtupleFColumn("px_MeV"); // 6
+    man->CreateNtupleFColumn("py_MeV"); // 7
+    man->CreateNtupleFColumn("pz_MeV"); // 8
+    man->CreateNtupleFColumn("x_mm"); // 9
+    man->CreateNtupleFColumn("y_mm"); // 10
+    man->CreateNtupleFColumn("z_mm"); // 11
+    man->CreateNtupleFColumn("time_ns"); // 12
+    man->FinishNtuple(4);
+
+    // Ntuple 5: share of each boundary particle in the energy of a cell
+    man->CreateNtuple("CellTruth", "Cell Energy Fractions by Boundary Particle");
+    man->CreateNtupleIColumn("event_id"); // 0
+    man->CreateNtupleIColumn("detid"); // 1
+    man->CreateNtupleIColumn("boundary_index"); // 2: -1 if not attributed
+    man->CreateNtupleFColumn("fraction"); // 3
+    man->FinishNtuple(5);
+    
+    // H1 0: energy deposited per silicon layer, summed over events
+    man->CreateH1("LayerEdep", "Energy deposited per silicon layer", 47, 0.5, 47.5);
 }
 
 MyRunAction::~MyRunAction() {
+    delete fMessenger;
+    delete fCutsMessenger;
+    delete fLibraryMessenger;
+    delete fStackMessenger;
+    delete fPremixMessenger;
+}
+
+G4int MyRunAction::GetLateSpecies(const G4ParticleDefinition* particle) {
+    switch (particle->GetPDGEncoding()) {
+        case 2112: return kLateNeutron;
+        case 22: return kLateGamma;
+        case 11: case -11: return kLateElectron;
+        case 2212: return kLateProton;
+        default: break;
+    }
+    return particle->GetParticleType() == "nucleus" ? kLateNucleus : kLateOther;
+}
+
+void MyRunAction::SetAsyncOutput(G4bool enable) {
+    AsyncOutput::SetEnabled(enable);
+}
+
+void MyRunAction::SetAsyncBuffers(G4int nBuffers) {
+    AsyncOutput::SetBuffersPerThread(nBuffers);
+}
+
+void MyRunAction::SetBoundaryTruth(G4bool enable) {
+    BoundaryTruth::SetEnabled(enable);
+}
+
+void MyRunAction::SetShowerLibraryMode(const G4String& mode) {
+    if (mode == "generate") {
+        ShowerLibrary::SetMode(ShowerLibrary::kGenerate);
+    } else if (mode == "use") {
+        ShowerLibrary::SetMode(ShowerLibrary::kUse);
+    } else {
+        ShowerLibrary::SetMode(ShowerLibrary::kOff);
+    }
+}
+
+void MyRunAction::SetShowerLibraryFile(const G4String& fileName) {
+    // Only the master opens or writes the library
+    if (IsMaster()) {
+        ShowerLibrary::Instance().SetFileName(fileName);
+    }
+}
+
+void MyRunAction::SetShowerLibraryMaxPerBin(G4int maxShowers) {
+    if (IsMaster()) {
+        ShowerLibrary::Instance().SetMaxShowersPerBin(maxShowers);
+    }
+}
+
+void MyRunAction::SetPremixMode(const G4String& mode) {
+    if (mode == "produce") {
+        PremixLibrary::SetMode(PremixLibrary::kProduce);
+    } else if (mode == "overlay") {
+        PremixLibrary::SetMode(PremixLibrary::kOverlay);
+    } else {
+        PremixLibrary::SetMode(PremixLibrary::kOff);
+    }
+}
+
+void MyRunAction::SetPremixFile(const G4String& fileName) {
+    // Only the master opens or writes the library
+    if (IsMaster()) {
+        PremixLibrary::Instance().SetFileName(fileName);
+    }
+}
+
+void MyRunAction::SetPremixMeanPileup(G4double mu) {
+    if (IsMaster()) {
+        PremixLibrary::Instance().SetMeanPileup(mu);
+    }
 }
 
 void MyRunAction::BeginOfRunAction(const G4Run* run) {
     G4AnalysisManager* man = G4AnalysisManager::Instance();
-    man->OpenFile("Photon_Pt_200_Eta_195_Events_2K_PU_000_Set01_Step1.root");
+    fRunID = run->GetRunID();
+
+    // New output file: export the geometry of every cell again
+    if (IsMaster()) {
+        MyEventAction::ResetCellGeometry();
+    }
+    G4AccumulableManager::Instance()->Reset();
+    if (IsMaster()) {
+        fTimer.Start();
+
+        // Shower library: mapped before the workers start, or emptied for recording
+        ShowerLibrary& library = ShowerLibrary::Instance();
+        if (ShowerLibrary::GetMode() == ShowerLibrary::kUse) {
+            library.Open();
+        } else if (ShowerLibrary::GetMode() == ShowerLibrary::kGenerate) {
+            library.ClearShowers();
+        }
+
+        // Premix library: mapped before the workers start, or emptied for production
+        PremixLibrary& premix = PremixLibrary::Instance();
+        if (PremixLibrary::GetMode() == PremixLibrary::kOverlay) {
+            premix.Open();
+        } else if (PremixLibrary::GetMode() == PremixLibrary::kProduce) {
+            premix.ClearEvents();
+        }
+    }
+
+    // Asynchronous output: hit-level ntuples leave the analysis manager file
+    G4bool async = AsyncOutput::IsEnabled();
+    man->SetActivation(async);
+    for (G4int id = 1; id <= 5; ++id) {
+        man->SetNtupleActivation(id, !async);
+    }
+    if (async && IsMaster()) {
+        AsyncOutput::Instance().Open(kAsyncOutputFile, G4RunManager::GetRunManager()->GetNumberOfThreads());
+    }
+
+    man->OpenFile(kOutputFile);
 }
 
-void MyRunAction::EndOfRunAction(const G4Run*) {
+void MyRunAction::EndOfRunAction(const G4Run* run) {
     G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    // Throughput and per-layer response, used to compare production-cut sets
+    // (worker histograms are merged into the master's by now)
+    if (IsMaster()) {
+        fTimer.Stop();
+        PrintLayerResponse(run);
+    }
+
     man->Write();
     man->CloseFile();
+
+    // Workers are done: flush the writer thread and report back-pressure
+    G4AccumulableManager::Instance()->Merge();
+    if (IsMaster()) {
+        AsyncOutput::Instance().Close();
+        if (ShowerLibrary::GetMode() == ShowerLibrary::kGenerate) {
+            ShowerLibrary::Instance().Write();
+        }
+        if (PremixLibrary::GetMode() == PremixLibrary::kProduce) {
+            PremixLibrary::Instance().Write();
+        } else if (PremixLibrary::GetMode() == PremixLibrary::kOverlay) {
+            PremixLibrary::Instance().PrintOverlaySummary();
+        }
+        PrintCounters(run);
+    }
+}
+
+void MyRunAction::PrintCounters(const G4Run* run) const {
+    G4cout << "========================================" << G4endl;
+    G4double seconds = fTimer.GetRealElapsed();
+    G4int nEvents = run->GetNumberOfEvent();
+    G4cout << "Steps: " << fSteps.GetValue();
+    if (nEvents > 0) {
+        G4cout << " (" << fSteps.GetValue() / nEvents << " steps/event)";
+    }
+    if (seconds > 0.) {
+        G4cout << " (" << fSteps.GetValue() / seconds << " steps/s)";
+    }
+    G4cout << G4endl;
+    G4cout << "Generator filter and looper killer:" << G4endl;
+    if (fGenerated.GetValue() > 0) {
+        G4cout << "  Primaries read:          " << fGenerated.GetValue() << G4endl;
+        G4cout << "  Filtered (eta window):   " << fFilteredEta.GetValue() << G4endl;
+        G4cout << "  Filtered (pT / bore):    " << fFilteredPt.GetValue() << G4endl;
+        G4cout << "  Dropped (propagation):   " << fDropped.GetValue() << G4endl;
+    }
+    G4cout << "  Loopers killed:          " << fLoopersKilled.GetValue() << G4endl;
+    G4cout << "  Backward tracks killed:  " << fBackwardKilled.GetValue() << G4endl;
+    G4cout << "  Killed kinetic energy:   " << fKilledEnergy.GetValue() / GeV << " GeV" << G4endl;
+    G4cout << "  Neutrinos killed:        " << fNeutrinosKilled.GetValue()
+           << " (" << fNeutrinoEnergy.GetValue() / GeV << " GeV)" << G4endl;
+    if (fTimeCut > 0.) {
+        G4bool measure = fTimeCutMeasure;
+        G4cout << "Time cut " << fTimeCut / ns << " ns (" << fTimeCutMode << "), per species:" << G4endl;
+        G4cout << "  " << std::setw(8) << "species" << std::setw(12) << "tracks" << std::setw(14) << "Ekin [MeV]";
+        if (measure) G4cout << std::setw(14) << "steps" << std::setw(12) << "CPU [s]";
+        G4cout << G4endl;
+        for (G4int species = 0; species < kNumLateSpecies; ++species) {
+            G4cout << "  " << std::setw(8) << kLateSpeciesNames[species]
+                   << std::setw(12) << fLateTracks[species].GetValue()
+                   << std::setw(14) << fLateEnergy[species].GetValue() / MeV;
+            if (measure) {
+                G4cout << std::setw(14) << fLateSteps[species].GetValue()
+                       << std::setw(12) << fLateSeconds[species].GetValue();
+            }
+            G4cout << G4endl;
+        }
+    }
+    G4int stackEvents = fStackEvents.GetValue();
+    if (stackEvents > 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        G4cout << "Stacking (" << fPrimariesPerStage << " primaries per stage):" << G4endl;
+        G4cout << "  Mean peak stack size:    " << fPeakStackSum.GetValue() / stackEvents << " tracks" << G4endl;
+        G4cout << "  Mean resident memory:    " << fResidentSum.GetValue() / stackEvents << " MB" << G4endl;
+        G4cout << "  Peak resident memory:    " << usage.ru_maxrss / 1024. << " MB" << G4endl;
+    }
+    G4cout << "========================================" << G4endl;
+}
+
+void MyRunAction::PrintLayerResponse(const G4Run* run) const {
+    G4int nEvents = run->GetNumberOfEvent();
+    if (nEvents == 0) return;
+
+    G4double seconds = fTimer.GetRealElapsed();
+    G4cout << "========================================" << G4endl;
+    G4cout << "Run " << run->GetRunID() << ": " << nEvents << " events in " << seconds << " s";
+    if (seconds > 0.) {
+        G4cout << " (" << nEvents / seconds << " events/s)";
+    }
+    G4cout << G4endl;
+
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    tools::histo::h1d* layerEdep = man->GetH1(0);
+    if (!layerEdep) return;
+
+    G4cout << "Mean energy per event per silicon layer [MeV]:" << G4endl;
+    G4double total = 0.;
+    for (unsigned int i = 0; i < layerEdep->get_bins(); ++i) {
+        G4double mean = layerEdep->bin_height(i) / nEvents;
+        total += mean;
+        G4cout << "  layer " << std::setw(2) << i + 1 << ": " << mean << G4endl;
+    }
+    G4cout << "  total   : " << total << G4endl;
+    G4cout << "========================================" << G4endl;
 }
@@ -1,20 +1,44 @@
 #include <iostream>
+#include <cstdlib>
 #include "G4RunManager.hh"
+#include "G4RunManagerFactory.hh"
 #include "G4UImanager.hh"
 #include "G4PhysListFactory.hh"  
 #include "construction.hh"
+#include "FastSimWorld.hh"
+#include "G4FastSimulationPhysics.hh"
 #include "action.hh"
 
 int main(int argc, char** argv) {
-    // Run manager
-    G4RunManager* runManager = new G4RunManager();
+    // Number of worker threads: second command-line argument (default: sequential)
+    G4int nThreads = (argc > 2) ? std::atoi(argv[2]) : 1;
+
+    // Run manager: MT/tasking when more than one thread is requested
+    G4RunManagerType runManagerType = (nThreads > 1) ? G4RunManagerType::Default
+                                                     : G4RunManagerType::Serial;
+    G4RunManager* runManager = G4RunManagerFactory::CreateRunManager(runManagerType);
+    if (nThreads > 1) {
+        runManager->SetNumberOfThreads(nThreads);
+    }
     
-    // Detector construction
-    runManager->SetUserInitialization(new MyDetectorConstruction());
+    // Detector construction, with the CE-E fast-simulation envelope in a parallel world
+    MyDetectorConstruction* detector = new MyDetectorConstruction();
+    G4String fastSimWorldName = "CEEFastSimWorld";
+    detector->RegisterParallelWorld(new MyFastSimWorld(fastSimWorldName, detector));
+    runManager->SetUserInitialization(detector);
 
     // Physics list (load built-in FTFP_BERT)
     G4PhysListFactory factory;
     auto physicsList = factory.GetReferencePhysList("FTFP_BERT");
+    // GFlash e+- showers in the CE-E envelope (off until /GFlash/flag 1)
+    G4FastSimulationPhysics* fastSimulationPhysics = new G4FastSimulationPhysics();
+    fastSimulationPhysics->ActivateFastSimulation("e-", fastSimWorldName);
+    fastSimulationPhysics->ActivateFastSimulation("e+", fastSimWorldName);
+    // Shower library for low-energy gamma/e+- in the absorbers (mass geometry)
+    fastSimulationPhysics->ActivateFastSimulation("gamma");
+    fastSimulationPhysics->ActivateFastSimulation("e-");
+    fastSimulationPhysics->ActivateFastSimulation("e+");
+    physicsList->RegisterPhysics(fastSimulationPhysics);
     runManager->SetUserInitialization(physicsList);
 
     // Action initialization
@@ -40,4 +64,4 @@ int main(int argc, char** argv) {
     delete runManager;
     
     return 0;
-}
\ No newline at end of file
+}
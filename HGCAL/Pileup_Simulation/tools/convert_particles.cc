@@ -0,0 +1,81 @@
+// Convert a generated_data.txt particle list into the compact binary
+// format read by ParticleFileReader (see ParticleFileReader.hh).
+//
+// Usage: convert_particles <input.txt> <output.bin>
+
+#include "ParticleFileReader.hh"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.bin>" << std::endl;
+        return 1;
+    }
+
+    ParticleFileReader reader;
+    if (!reader.Open(argv[1])) return 1;
+    if (reader.IsBinary()) {
+        std::cerr << "ERROR: " << argv[1] << " is already a binary particle file" << std::endl;
+        return 1;
+    }
+
+    // Every event is read anyway: check the order once up front, so the
+    // range below covers an unsorted file too
+    reader.CheckOrder();
+
+    G4int firstEventID = 0;
+    G4int lastEventID = -1;
+    if (!reader.GetEventRange(firstEventID, lastEventID)) {
+        std::cerr << "ERROR: No events found in " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // Decode event by event; events missing from the text file stay empty
+    std::uint32_t nEvents = static_cast<std::uint32_t>(lastEventID - firstEventID + 1);
+    std::vector<std::uint64_t> eventOffsets(nEvents + 1, 0);
+    std::vector<ParticleRecord> records;
+    std::vector<ParticleGenInfo> particles;
+
+    for (std::uint32_t i = 0; i < nEvents; ++i) {
+        eventOffsets[i] = records.size();
+        reader.ReadEvent(firstEventID + static_cast<G4int>(i), particles);
+        for (const ParticleGenInfo& p : particles) {
+            records.push_back({p.eventID, p.cumTr, p.pdgID,
+                               static_cast<float>(p.pt), static_cast<float>(p.phi),
+                               static_cast<float>(p.theta), static_cast<float>(p.eta)});
+        }
+    }
+    eventOffsets[nEvents] = records.size();
+
+    ParticleFileHeader header;
+    std::memcpy(header.magic, "HGCPART1", 8);
+    header.version = 1;
+    header.recordSize = sizeof(ParticleRecord);
+    header.firstEventID = firstEventID;
+    header.nEvents = nEvents;
+    header.nRecords = records.size();
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "ERROR: Cannot create output file: " << argv[2] << std::endl;
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(eventOffsets.data()),
+              eventOffsets.size() * sizeof(std::uint64_t));
+    out.write(reinterpret_cast<const char*>(records.data()),
+              records.size() * sizeof(ParticleRecord));
+    if (!out) {
+        std::cerr << "ERROR: Failed writing " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << records.size() << " particles in " << nEvents
+              << " events (Evt# " << firstEventID << " to " << lastEventID << ") to "
+              << argv[2] << std::endl;
+    return 0;
+}
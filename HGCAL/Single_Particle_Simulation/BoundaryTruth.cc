@@ -0,0 +1,29 @@
+#include "BoundaryTruth.hh"
+#include "TrackInformation.hh"
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+
+std::atomic<G4bool> BoundaryTruth::fEnabled{false};
+
+BoundaryTruth& BoundaryTruth::Instance()
+{
+    static G4ThreadLocal BoundaryTruth* instance = nullptr;
+    if (!instance) {
+        instance = new BoundaryTruth();
+    }
+    return *instance;
+}
+
+G4int BoundaryTruth::Add(const G4Track* track, const G4StepPoint* point)
+{
+    BoundaryParticle particle;
+    particle.trackID = track->GetTrackID();
+    particle.particleID = track->GetDefinition()->GetPDGEncoding();
+    particle.cumTr = TrackInformation::CumTrOf(track);
+    particle.energy = point->GetKineticEnergy();
+    particle.momentum = point->GetMomentum();
+    particle.position = point->GetPosition();
+    particle.time = point->GetGlobalTime();
+    fParticles.push_back(particle);
+    return static_cast<G4int>(fParticles.size()) - 1;
+}
@@ -0,0 +1,77 @@
+#include "FastSimWorld.hh"
+#include "construction.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4Tubs.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4AutoDelete.hh"
+#include "GFlashShowerModel.hh"
+#include "GFlashSamplingShowerParameterisation.hh"
+#include "GFlashParticleBounds.hh"
+#include "GFlashHitMaker.hh"
+
+MyFastSimWorld::MyFastSimWorld(const G4String& worldName, const MyDetectorConstruction* detector)
+: G4VUserParallelWorld(worldName), fDetector(detector) {}
+
+MyFastSimWorld::~MyFastSimWorld() {}
+
+void MyFastSimWorld::Construct() {
+    // Called after the mass geometry, so the CE-E summary is available
+    G4double zFront = fDetector->GetFrontFaceZ();
+    G4double zBack = fDetector->GetCEEBackZ();
+    G4double halfLength = (zBack - zFront) / 2.0;
+
+    G4Tubs* solidEnvelope = new G4Tubs("solid_CEEEnvelope", fDetector->GetCEEInnerRadius(),
+                                       fDetector->GetCEEOuterRadius(), halfLength, 0.0, 2.0 * CLHEP::pi);
+    // No material: the ghost volume only marks where showers may be parameterised
+    G4LogicalVolume* logicEnvelope = new G4LogicalVolume(solidEnvelope, nullptr, "logic_CEEEnvelope");
+
+    new G4PVPlacement(
+        0,
+        G4ThreeVector(0, 0, zFront + halfLength),
+        logicEnvelope,
+        "phys_CEEEnvelope",
+        GetWorld()->GetLogicalVolume(),
+        false,
+        0,
+        false
+    );
+
+    G4Region* region = G4RegionStore::GetInstance()->FindOrCreateRegion("CEEFastSim");
+    region->AddRootLogicalVolume(logicEnvelope);
+}
+
+void MyFastSimWorld::ConstructSD() {
+    // One model per thread. GFlash only parameterises e+-: photons convert in
+    // full simulation and their pairs are picked up by the model.
+    // The region and its model outlive a geometry rebuild and are built once;
+    // the sampling parameterisation is rebuilt every time, so it follows the
+    // CE-E passive mixture of the current geometry.
+    static G4ThreadLocal GFlashShowerModel* showerModel = nullptr;
+    if (!showerModel) {
+        G4Region* region = G4RegionStore::GetInstance()->GetRegion("CEEFastSim");
+
+        showerModel = new GFlashShowerModel("CEEShowerModel", region);
+        GFlashParticleBounds* particleBounds = new GFlashParticleBounds();
+        GFlashHitMaker* hitMaker = new GFlashHitMaker();
+
+        showerModel->SetParticleBounds(*particleBounds);
+        showerModel->SetHitMaker(*hitMaker);
+        // Full simulation unless switched on with /GFlash/flag 1
+        showerModel->SetFlagParamType(0);
+
+        G4AutoDelete::Register(showerModel);
+        G4AutoDelete::Register(particleBounds);
+        G4AutoDelete::Register(hitMaker);
+    }
+
+    // The model only keeps a reference: the previous parameterisation stays
+    // registered for deletion at exit
+    GFlashSamplingShowerParameterisation* parameterisation = new GFlashSamplingShowerParameterisation(
+        fDetector->GetCEEPassiveMaterial(), G4Material::GetMaterial("G4_Si"),
+        fDetector->GetCEEPassiveThickness(), fDetector->GetCEEActiveThickness());
+    showerModel->SetParameterisation(*parameterisation);
+    G4AutoDelete::Register(parameterisation);
+}
@@ -0,0 +1,25 @@
+#ifndef FASTSIMWORLD_HH
+#define FASTSIMWORLD_HH
+
+#include "G4VUserParallelWorld.hh"
+#include "globals.hh"
+
+class MyDetectorConstruction;
+
+// Parallel world holding the CE-E envelope for the GFlash shower model.
+// The envelope lives outside the mass geometry so that its region does not
+// replace the production-cut regions of the layers it contains. The model is
+// off by default; /GFlash/flag 1 switches to parameterised e+- showers.
+class MyFastSimWorld : public G4VUserParallelWorld {
+public:
+    MyFastSimWorld(const G4String& worldName, const MyDetectorConstruction* detector);
+    virtual ~MyFastSimWorld();
+
+    virtual void Construct() override;
+    virtual void ConstructSD() override;
+
+private:
+    const MyDetectorConstruction* fDetector;
+};
+
+#endif
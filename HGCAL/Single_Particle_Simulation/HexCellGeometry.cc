@@ -0,0 +1,97 @@
+#include "HexCellGeometry.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const G4double sqrt3 = std::sqrt(3.0);
+
+    // Round fractional axial coordinates to the nearest hexagon (cube rounding)
+    void AxialRound(G4double q, G4double r, G4int& qi, G4int& ri) {
+        G4double s = -q - r;
+        G4double rq = std::round(q);
+        G4double rr = std::round(r);
+        G4double rs = std::round(s);
+        G4double dq = std::fabs(rq - q);
+        G4double dr = std::fabs(rr - r);
+        G4double ds = std::fabs(rs - s);
+        if (dq > dr && dq > ds) {
+            rq = -rr - rs;
+        } else if (dr > ds) {
+            rr = -rq - rs;
+        }
+        qi = static_cast<G4int>(rq);
+        ri = static_cast<G4int>(rr);
+    }
+
+    // Signed wafer index: sign bit + 5-bit magnitude
+    std::uint32_t PackSigned(G4int value) {
+        std::uint32_t magnitude = static_cast<std::uint32_t>(std::abs(value)) & 0x1f;
+        return (value < 0 ? 0x20u : 0u) | magnitude;
+    }
+
+    G4int UnpackSigned(std::uint32_t bits) {
+        G4int magnitude = static_cast<G4int>(bits & 0x1f);
+        return (bits & 0x20) ? -magnitude : magnitude;
+    }
+}
+
+HexCell HexCellGeometry::Locate(G4double x, G4double y) {
+    HexCell cell;
+
+    // Wafer: pointy-top lattice with circumradius W / sqrt3
+    const G4double waferRadius = kWaferSize / sqrt3;
+    G4int q, r;
+    AxialRound((sqrt3 / 3.0 * x - y / 3.0) / waferRadius, (2.0 / 3.0 * y) / waferRadius, q, r);
+    cell.waferU = q + r;
+    cell.waferV = r;
+
+    G4double waferX, waferY;
+    WaferCenter(cell.waferU, cell.waferV, waferX, waferY);
+    cell.highDensity = std::hypot(waferX, waferY) < kHighDensityRadius;
+
+    // Cell: flat-top lattice in the wafer frame with circumradius W / (3N)
+    const G4int n = CellsPerEdge(cell.highDensity);
+    const G4double cellRadius = kWaferSize / (3.0 * n);
+    const G4double localX = x - waferX;
+    const G4double localY = y - waferY;
+    AxialRound((2.0 / 3.0 * localX) / cellRadius,
+               (-localX / 3.0 + sqrt3 / 3.0 * localY) / cellRadius, q, r);
+    cell.cellU = std::clamp(q + n, 0, 2 * n);
+    cell.cellV = std::clamp(r + n, 0, 2 * n);
+    return cell;
+}
+
+void HexCellGeometry::WaferCenter(G4int waferU, G4int waferV, G4double& x, G4double& y) {
+    x = kWaferSize * (waferU - 0.5 * waferV);
+    y = kWaferSize * (0.5 * sqrt3) * waferV;
+}
+
+void HexCellGeometry::CellCenter(const HexCell& cell, G4double& x, G4double& y) {
+    WaferCenter(cell.waferU, cell.waferV, x, y);
+    const G4int n = CellsPerEdge(cell.highDensity);
+    const G4double cellRadius = kWaferSize / (3.0 * n);
+    const G4int q = cell.cellU - n;
+    const G4int r = cell.cellV - n;
+    x += cellRadius * 1.5 * q;
+    y += cellRadius * sqrt3 * (r + 0.5 * q);
+}
+
+std::uint32_t HexCellGeometry::PackDetId(G4int layer, const HexCell& cell, G4int zside) {
+    return (static_cast<std::uint32_t>(kSubdetSilicon & 0x3) << 30)
+         | (static_cast<std::uint32_t>(zside > 0 ? 1 : 0) << 29)
+         | (static_cast<std::uint32_t>(layer & 0x3f) << 23)
+         | (static_cast<std::uint32_t>(cell.highDensity ? 0 : 1) << 22)
+         | (PackSigned(cell.waferU) << 16)
+         | (PackSigned(cell.waferV) << 10)
+         | (static_cast<std::uint32_t>(cell.cellU & 0x1f) << 5)
+         | static_cast<std::uint32_t>(cell.cellV & 0x1f);
+}
+
+void HexCellGeometry::UnpackDetId(std::uint32_t detId, G4int& layer, HexCell& cell) {
+    layer = Layer(detId);
+    cell.highDensity = ((detId >> 22) & 0x1) == 0;
+    cell.waferU = UnpackSigned(detId >> 16);
+    cell.waferV = UnpackSigned(detId >> 10);
+    cell.cellU = static_cast<G4int>((detId >> 5) & 0x1f);
+    cell.cellV = static_cast<G4int>(detId & 0x1f);
+}
@@ -0,0 +1,57 @@
+#ifndef HEXCELLGEOMETRY_HH
+#define HEXCELLGEOMETRY_HH
+
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+#include <cstdint>
+
+// Hexagonal silicon cell of one HGCAL layer
+struct HexCell {
+    G4int waferU;       // wafer axial coordinates (signed)
+    G4int waferV;
+    G4int cellU;        // cell axial coordinates inside the wafer, 0..2N
+    G4int cellV;
+    G4bool highDensity; // HD wafer (N = 12) or LD wafer (N = 8)
+};
+
+// Constant-time mapping between transverse positions and hexagonal cells.
+//
+// Wafers tile the layer as "pointy-top" hexagons with flat-to-flat size
+// kWaferSize; wafer (u, v) is centred at x = W (u - v/2), y = W (sqrt3/2) v.
+// Inside a wafer, cells are "flat-top" hexagons of circumradius W / (3N),
+// giving the ~3N^2 cells (plus partial ones on the edges) of CMSSW HD (N = 12)
+// and LD (N = 8) wafers. Cell (u, v) are the cell axial coordinates
+// shifted by N so that they are non-negative.
+class HexCellGeometry {
+public:
+    static constexpr G4double kWaferSize = 166.4408 * mm;
+    static constexpr G4int kCellsHD = 12;
+    static constexpr G4int kCellsLD = 8;
+
+    // Wafers whose centre is inside this radius are high density. CMSSW
+    // varies the boundary per layer; a single radius is enough here.
+    static constexpr G4double kHighDensityRadius = 70.0 * cm;
+
+    static HexCell Locate(G4double x, G4double y);
+    static void WaferCenter(G4int waferU, G4int waferV, G4double& x, G4double& y);
+    static void CellCenter(const HexCell& cell, G4double& x, G4double& y);
+    static G4int CellsPerEdge(G4bool highDensity) { return highDensity ? kCellsHD : kCellsLD; }
+
+    // Packed 32-bit detector ID:
+    //   subdetector (2) | z side (1) | layer (6) | type (1, LD = 1) |
+    //   wafer u (sign + 5) | wafer v (sign + 5) | cell u (5) | cell v (5)
+    static constexpr G4int kSubdetSilicon = 1;
+    static std::uint32_t PackDetId(G4int layer, const HexCell& cell, G4int zside = 1);
+    static void UnpackDetId(std::uint32_t detId, G4int& layer, HexCell& cell);
+    static G4int Subdetector(std::uint32_t detId) { return (detId >> 30) & 0x3; }
+    static G4int ZSide(std::uint32_t detId) { return (detId >> 29) & 0x1; }
+    static G4int Layer(std::uint32_t detId) { return (detId >> 23) & 0x3f; }
+
+    // Dense 28-bit index of a detector ID (type and z side dropped), for bitmaps
+    static constexpr std::uint32_t kDenseIndexBits = 28;
+    static std::uint32_t DenseIndex(std::uint32_t detId) {
+        return (static_cast<std::uint32_t>(Layer(detId)) << 22) | (detId & 0x3fffff);
+    }
+};
+
+#endif
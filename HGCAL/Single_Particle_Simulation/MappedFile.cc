@@ -0,0 +1,49 @@
+#include "MappedFile.hh"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : fData(nullptr), fSize(0) {}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+G4bool MappedFile::Open(const G4String& filename) {
+    Close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        G4cout << "ERROR: Cannot open file: " << filename << G4endl;
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        G4cout << "ERROR: Cannot stat file or file is empty: " << filename << G4endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping stays valid after closing the descriptor
+    if (addr == MAP_FAILED) {
+        G4cout << "ERROR: Cannot memory-map file: " << filename << G4endl;
+        return false;
+    }
+
+    fData = static_cast<const char*>(addr);
+    fSize = static_cast<std::size_t>(st.st_size);
+    fFileName = filename;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (fData) {
+        ::munmap(const_cast<char*>(fData), fSize);
+    }
+    fData = nullptr;
+    fSize = 0;
+    fFileName = "";
+}
@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_HH
+#define MAPPEDFILE_HH
+
+#include "globals.hh"
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Pages are shared between all
+// threads (and all jobs on the node) that map the same file.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    G4bool Open(const G4String& filename);
+    void Close();
+
+    G4bool IsOpen() const { return fData != nullptr; }
+    const char* Data() const { return fData; }
+    std::size_t Size() const { return fSize; }
+    const G4String& GetFileName() const { return fFileName; }
+
+private:
+    const char* fData;
+    std::size_t fSize;
+    G4String fFileName;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "PremixLibrary.hh"
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+std::atomic<G4int> PremixLibrary::fMode{PremixLibrary::kOff};
+
+PremixLibrary& PremixLibrary::Instance()
+{
+    static PremixLibrary instance;
+    return instance;
+}
+
+PremixLibrary::PremixLibrary()
+: fFileName("premix_library.bin"), fMeanPileup(200.),
+  fHeader(nullptr), fEventOffsets(nullptr), fCells(nullptr),
+  fSignalEvents(0), fOverlaidEvents(0)
+{}
+
+PremixLibrary::~PremixLibrary() {}
+
+G4bool PremixLibrary::Open()
+{
+    Close();
+    if (!fFile.Open(fFileName)) {
+        G4cout << "ERROR: Cannot open premix library: " << fFileName << G4endl;
+        return false;
+    }
+
+    const PremixLibraryHeader* header = reinterpret_cast<const PremixLibraryHeader*>(fFile.Data());
+    G4bool valid = fFile.Size() >= sizeof(PremixLibraryHeader) &&
+                   std::memcmp(header->magic, "HGCPMIX1", 8) == 0 &&
+                   header->version == 1 && header->nEvents > 0;
+    if (valid) {
+        // Bound both counts by the file size first so the sum cannot wrap
+        const std::uint64_t size = fFile.Size();
+        valid = header->nEvents < size / sizeof(std::uint64_t) &&
+                header->nCells <= size / sizeof(PremixCell);
+        if (valid) {
+            std::uint64_t expected = sizeof(PremixLibraryHeader)
+                                   + (header->nEvents + 1) * sizeof(std::uint64_t)
+                                   + header->nCells * sizeof(PremixCell);
+            valid = size >= expected;
+        }
+    }
+    if (valid) {
+        // DrawEvent indexes cells straight from the offset table
+        const std::uint64_t* offsets = reinterpret_cast<const std::uint64_t*>(fFile.Data() + sizeof(PremixLibraryHeader));
+        for (std::uint64_t i = 0; valid && i <= header->nEvents; ++i) {
+            valid = offsets[i] <= header->nCells && (i == 0 || offsets[i] >= offsets[i - 1]);
+        }
+    }
+    if (!valid) {
+        G4cout << "ERROR: Unsupported, empty, truncated or corrupt premix library: " << fFileName << G4endl;
+        fFile.Close();
+        return false;
+    }
+
+    fHeader = header;
+    fEventOffsets = reinterpret_cast<const std::uint64_t*>(fFile.Data() + sizeof(PremixLibraryHeader));
+    fCells = reinterpret_cast<const PremixCell*>(fEventOffsets + fHeader->nEvents + 1);
+    fSignalEvents = 0;
+    fOverlaidEvents = 0;
+
+    G4cout << "Premix library " << fFileName << ": " << fHeader->nEvents << " events, "
+           << fHeader->nCells << " cells (" << static_cast<G4double>(fHeader->nCells) / fHeader->nEvents
+           << " per event), mu = " << fMeanPileup.load() << G4endl;
+    return true;
+}
+
+void PremixLibrary::Close()
+{
+    fFile.Close();
+    fHeader = nullptr;
+    fEventOffsets = nullptr;
+    fCells = nullptr;
+}
+
+G4int PremixLibrary::DrawPileupCount()
+{
+    G4int count = static_cast<G4int>(G4Poisson(fMeanPileup.load(std::memory_order_relaxed)));
+    fSignalEvents.fetch_add(1, std::memory_order_relaxed);
+    fOverlaidEvents.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+const PremixCell* PremixLibrary::DrawEvent(std::size_t& nCells) const
+{
+    std::uint64_t count = fHeader->nEvents;
+    std::uint64_t pick = std::min(static_cast<std::uint64_t>(G4UniformRand() * count), count - 1);
+    nCells = fEventOffsets[pick + 1] - fEventOffsets[pick];
+    return fCells + fEventOffsets[pick];
+}
+
+void PremixLibrary::PrintOverlaySummary() const
+{
+    std::uint64_t signalEvents = fSignalEvents.load();
+    if (signalEvents == 0) return;
+    G4cout << "Premix overlay: " << fOverlaidEvents.load() << " library events on " << signalEvents
+           << " events (mean " << static_cast<G4double>(fOverlaidEvents.load()) / signalEvents
+           << ", mu = " << fMeanPileup.load() << ")" << G4endl;
+}
+
+void PremixLibrary::AddEvent(const std::vector<PremixCell>& cells)
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStoredOffsets.push_back(fStoredCells.size());
+    fStoredCells.insert(fStoredCells.end(), cells.begin(), cells.end());
+}
+
+void PremixLibrary::ClearEvents()
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStoredOffsets.clear();
+    fStoredCells.clear();
+}
+
+G4bool PremixLibrary::Write()
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    PremixLibraryHeader header;
+    std::memcpy(header.magic, "HGCPMIX1", 8);
+    header.version = 1;
+    header.reserved = 0;
+    header.nEvents = fStoredOffsets.size();
+    header.nCells = fStoredCells.size();
+
+    std::ofstream out(fFileName, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(fStoredOffsets.data()), fStoredOffsets.size() * sizeof(std::uint64_t));
+    std::uint64_t end = fStoredCells.size();
+    out.write(reinterpret_cast<const char*>(&end), sizeof(end));
+    out.write(reinterpret_cast<const char*>(fStoredCells.data()), fStoredCells.size() * sizeof(PremixCell));
+    if (!out) {
+        G4cout << "ERROR: Cannot write premix library: " << fFileName << G4endl;
+        return false;
+    }
+
+    G4cout << "Premix library written to " << fFileName << ": " << header.nEvents << " events, "
+           << header.nCells << " cells" << G4endl;
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef PREMIXLIBRARY_HH
+#define PREMIXLIBRARY_HH
+
+#include "globals.hh"
+#include "MappedFile.hh"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Premix library file ("HGCPMIX1"), written in production mode:
+//   PremixLibraryHeader
+//   uint64_t eventOffsets[nEvents + 1]  first cell of each event
+//   PremixCell cells[nCells]            grouped by event
+// An event is the CellHits content of one simulated minimum-bias interaction.
+struct PremixLibraryHeader {
+    char magic[8];            // "HGCPMIX1"
+    std::uint32_t version;    // 1
+    std::uint32_t reserved;
+    std::uint64_t nEvents;
+    std::uint64_t nCells;
+};
+
+struct PremixCell {
+    std::uint32_t detId;      // HexCellGeometry::PackDetId
+    float edep;               // [MeV]
+    float time;               // earliest deposit [ns]
+    float z;                  // centre of the silicon layer [mm]
+};
+
+static_assert(sizeof(PremixLibraryHeader) == 32, "unexpected PremixLibraryHeader padding");
+static_assert(sizeof(PremixCell) == 16, "unexpected PremixCell padding");
+
+// Digital pileup premixing. Production: every event of a minimum-bias run
+// (one interaction per event) is stored cell by cell by the workers and
+// written by the master at the end of the run. Overlay: the library is
+// memory-mapped once by the master; the sensitive detector adds
+// Poisson(mu) randomly drawn library events to the cells of each event.
+class PremixLibrary {
+public:
+    enum Mode { kOff = 0, kProduce = 1, kOverlay = 2 };
+
+    // Boundary index of overlaid energy in CellTruth
+    static constexpr G4int kPremixIndex = -2;
+
+    static PremixLibrary& Instance();
+
+    static void SetMode(G4int mode) { fMode = mode; }
+    static G4int GetMode() { return fMode; }
+
+    void SetFileName(const G4String& fileName) { fFileName = fileName; }
+    const G4String& GetFileName() const { return fFileName; }
+    void SetMeanPileup(G4double mu) { fMeanPileup = mu; }
+    G4double GetMeanPileup() const { return fMeanPileup; }
+
+    // Overlay mode (master, before the workers start)
+    G4bool Open();
+    void Close();
+    G4bool IsOpen() const { return fHeader != nullptr; }
+    // Number of library events for one signal event: Poisson(mu), counted
+    G4int DrawPileupCount();
+    // Random library event; cells and their number
+    const PremixCell* DrawEvent(std::size_t& nCells) const;
+    void PrintOverlaySummary() const;
+
+    // Production mode
+    void AddEvent(const std::vector<PremixCell>& cells);
+    void ClearEvents();
+    G4bool Write();
+
+private:
+    PremixLibrary();
+    ~PremixLibrary();
+
+    static std::atomic<G4int> fMode;
+
+    G4String fFileName;
+    std::atomic<G4double> fMeanPileup;
+
+    MappedFile fFile;
+    const PremixLibraryHeader* fHeader;
+    const std::uint64_t* fEventOffsets;
+    const PremixCell* fCells;
+
+    // Overlay statistics of the run
+    std::atomic<std::uint64_t> fSignalEvents;
+    std::atomic<std::uint64_t> fOverlaidEvents;
+
+    std::mutex fMutex;
+    std::vector<std::uint64_t> fStoredOffsets;  // first cell of each stored event
+    std::vector<PremixCell> fStoredCells;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SHOWERLIBRARY_HH
+#define SHOWERLIBRARY_HH
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "MappedFile.hh"
+#include "construction.hh"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class G4Track;
+
+// Frozen shower library file ("HGCSHLB1"), written in generation mode:
+//   ShowerLibraryHeader
+//   uint64_t binOffsets[nBins + 1]     first shower of each bin
+//   ShowerRecord showers[nShowers]     grouped by bin
+//   ShowerDeposit deposits[nDeposits]  grouped by shower
+// A shower is everything a low-energy particle started in the absorbers (and
+// its descendants) deposited in silicon, relative to its own frame.
+struct ShowerLibraryHeader {
+    char magic[8];            // "HGCSHLB1"
+    std::uint32_t version;    // 1
+    std::uint32_t nBins;      // ShowerLibrary::kNumBins of the writer
+    std::uint64_t nShowers;
+    std::uint64_t nDeposits;
+};
+
+struct ShowerRecord {
+    std::uint64_t firstDeposit;
+    float energy;             // kinetic energy of the recorded particle [MeV]
+    std::uint32_t nDeposits;  // 0: nothing reached the silicon
+};
+
+struct ShowerDeposit {
+    std::int32_t dPlane;      // sensor plane relative to the reference plane
+    float du;                 // transverse offset from the start point [mm]:
+    float dv;                 //   u along the transverse direction, v = z x u
+    float fraction;           // deposited energy / particle kinetic energy
+};
+
+static_assert(sizeof(ShowerLibraryHeader) == 32, "unexpected ShowerLibraryHeader padding");
+static_assert(sizeof(ShowerRecord) == 16, "unexpected ShowerRecord padding");
+static_assert(sizeof(ShowerDeposit) == 16, "unexpected ShowerDeposit padding");
+
+// Frame of a particle: the next sensor plane along its direction of flight
+// (downstream if pz >= 0, upstream otherwise) and the transverse axes
+struct ShowerFrame {
+    G4int refPlane;       // index into MyDetectorConstruction::GetSiliconPlanes()
+    G4double depth;       // distance along z to that plane
+    G4double cosTheta;
+    G4ThreeVector u;
+    G4ThreeVector v;
+};
+
+// Process-wide library: memory-mapped once by the master and read by all
+// workers (use mode), or filled by the workers' recorders and written by the
+// master at the end of the run (generation mode).
+class ShowerLibrary {
+public:
+    enum Mode { kOff = 0, kGenerate = 1, kUse = 2 };
+
+    // Binning: species (gamma, e-, e+) x energy x depth x |cos theta|
+    static constexpr G4int kNumSpecies = 3;
+    static constexpr G4int kNumEnergyBins = 7;   // 0.5 - 100 MeV
+    static constexpr G4int kNumDepthBins = 9;    // 0 - 128 mm
+    static constexpr G4int kNumAngleBins = 4;
+    static constexpr G4int kNumBins = kNumSpecies * kNumEnergyBins * kNumDepthBins * kNumAngleBins;
+    static const G4double kMinEnergy;
+    static const G4double kMaxEnergy;
+
+    static ShowerLibrary& Instance();
+
+    static void SetMode(G4int mode) { fMode = mode; }
+    static G4int GetMode() { return fMode; }
+
+    // -1 if the particle is not handled by the library
+    static G4int Species(G4int pdgCode);
+    static G4int BinIndex(G4int species, G4double energy, G4double depth, G4double cosTheta);
+    static G4bool MakeFrame(const G4ThreeVector& position, const G4ThreeVector& direction,
+                            const std::vector<SiliconPlane>& planes, ShowerFrame& frame);
+
+    void SetFileName(const G4String& fileName) { fFileName = fileName; }
+    const G4String& GetFileName() const { return fFileName; }
+    void SetMaxShowersPerBin(G4int maxShowers) { fMaxShowersPerBin = maxShowers; }
+
+    // Use mode (master, before the workers start)
+    G4bool Open();
+    void Close();
+    G4bool IsOpen() const { return fHeader != nullptr; }
+    G4bool HasShowers(G4int bin) const { return fBinOffsets[bin + 1] > fBinOffsets[bin]; }
+    // Random shower of a non-empty bin
+    const ShowerRecord& Draw(G4int bin) const;
+    const ShowerDeposit* Deposits(const ShowerRecord& shower) const { return fDeposits + shower.firstDeposit; }
+
+    // Generation mode
+    G4bool IsBinFull(G4int bin) const;
+    void AddShower(G4int bin, G4double energy, const std::vector<ShowerDeposit>& deposits);
+    void ClearShowers();
+    G4bool Write();
+
+private:
+    ShowerLibrary();
+    ~ShowerLibrary();
+
+    static std::atomic<G4int> fMode;
+
+    G4String fFileName;
+    std::atomic<G4int> fMaxShowersPerBin;
+
+    MappedFile fFile;
+    const ShowerLibraryHeader* fHeader;
+    const std::uint64_t* fBinOffsets;
+    const ShowerRecord* fShowers;
+    const ShowerDeposit* fDeposits;
+
+    struct StoredShower {
+        float energy;
+        std::vector<ShowerDeposit> deposits;
+    };
+    std::mutex fMutex;
+    std::vector<std::vector<StoredShower>> fStored;     // per bin
+    std::unique_ptr<std::atomic<G4int>[]> fStoredCount;  // per bin, read without the lock
+};
+
+// Per-thread recorder for generation mode. A root is a gamma/e+- started in
+// the EMAbsorbers region with 0.5-100 MeV; its descendants inherit it.
+//   BeginTrack:  tracking action, every track
+//   AddDeposit:  sensitive detector, every silicon step with energy
+//   EndOfEvent:  event action, hands the finished roots to the library
+class ShowerLibraryRecorder {
+public:
+    static ShowerLibraryRecorder& Instance();
+
+    void BeginTrack(const G4Track* track);
+    void AddDeposit(G4int trackID, G4int layer, const G4ThreeVector& position, G4double edep);
+    void EndOfEvent();
+
+private:
+    ShowerLibraryRecorder();
+
+    struct Root {
+        G4int bin;
+        G4double energy;
+        G4int refPlane;
+        G4ThreeVector origin;
+        G4ThreeVector u;
+        G4ThreeVector v;
+        std::vector<ShowerDeposit> deposits;
+    };
+    std::vector<Root> fRoots;
+    std::unordered_map<G4int, G4int> fTrackRoot;  // track ID -> root index
+    const std::vector<SiliconPlane>* fPlanes;
+};
+
+#endif
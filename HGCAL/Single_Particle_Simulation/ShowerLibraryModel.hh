@@ -0,0 +1,32 @@
+#ifndef SHOWERLIBRARYMODEL_HH
+#define SHOWERLIBRARYMODEL_HH
+
+#include "G4VFastSimulationModel.hh"
+#include "ShowerLibrary.hh"
+
+class MySensitiveDetector;
+
+// Fast simulation of low-energy gamma/e+- started in the absorbers
+// (EMAbsorbers region): the particle is killed on its first step and a
+// library shower of the same bin is stamped into the silicon cells, aligned
+// with its transverse direction and randomly mirrored. Active in use mode
+// (/hgcal/showerLibrary/mode use); bins without showers stay in full simulation.
+class MyShowerLibraryModel : public G4VFastSimulationModel {
+public:
+    MyShowerLibraryModel(const G4String& name, G4Region* region);
+    virtual ~MyShowerLibraryModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle) override;
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack) override;
+    virtual void DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) override;
+
+private:
+    const std::vector<SiliconPlane>* fPlanes;
+    MySensitiveDetector* fSensitiveDetector;
+
+    // Set by ModelTrigger for the following DoIt
+    ShowerFrame fFrame;
+    G4int fBin;
+};
+
+#endif
@@ -8,6 +8,7 @@ public:
     MyActionInitialization();
     virtual ~MyActionInitialization();
     
+    virtual void BuildForMaster() const;
     virtual void Build() const;
 };
 
@@ -1,5 +1,7 @@
 #include "construction.hh"
 #include "detector.hh"
+#include "ShowerLibraryModel.hh"
+#include "LayerStack.hh"
 #include "G4SDManager.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4VisAttributes.hh"
@@ -14,17 +16,130 @@
 #include "G4UniformMagField.hh"
 #include "G4FieldManager.hh"
 #include "G4TransportationManager.hh"
+#include "G4AutoDelete.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
+#include <algorithm>
+#include <cfloat>
+
+// Default tables, set by CMake to the repository's Data directory
+#ifndef HGCAL_LAYERS_CSV
+#define HGCAL_LAYERS_CSV "HGCAL_Layers_composition.csv"
+#endif
+#ifndef HGCAL_RADII_CSV
+#define HGCAL_RADII_CSV "HGCAL_Layers_radii.csv"
+#endif
+
+namespace {
+    // Mother whose z range holds z (the last one if none does)
+    const LayerMother& FindMother(const std::vector<LayerMother>& mothers, G4double z) {
+        for (const LayerMother& mother : mothers) {
+            if (z < mother.zEnd) return mother;
+        }
+        return mothers.back();
+    }
+}
+
+MyDetectorConstruction::MyDetectorConstruction()
+: fNesting(GeometryNesting::Flat), fFidelity(GeometryFidelity::Full), fConstructed(false),
+  fLayerFile(HGCAL_LAYERS_CSV), fRadiiFile(HGCAL_RADII_CSV), fWithGlue(false), fWithAir(false),
+  fFrontFaceZ(0.), fFrontInnerRadius(0.), fFrontOuterRadius(0.), fMinInnerRadius(0.),
+  fFieldZ(3.8*tesla), fCEEBackZ(0.), fCEEInnerRadius(0.), fCEEOuterRadius(0.),
+  fCEEPassive(nullptr), fCEEPassiveThickness(0.), fCEEActiveThickness(0.), fCEESiliconWeight(1.) {
+    fMessenger = new G4GenericMessenger(this, "/hgcal/geometry/", "Geometry layout");
+    fMessenger->DeclareMethod("nesting", &MyDetectorConstruction::SetNesting,
+                              "flat: layers in the world; envelope: in one endcap tube; "
+                              "cassette: endcap tube > cassette tubes > layers")
+        .SetCandidates("flat envelope cassette")
+        .SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("fidelity", &MyDetectorConstruction::SetFidelity,
+                              "full: every layer; merged: one mixture slab between sensors; toy: silicon + lead")
+        .SetCandidates("full merged toy")
+        .SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("layerFile", &MyDetectorConstruction::SetLayerFile,
+                              "Layer composition table (CSV: Layer #, Material, Z min, Z max)")
+        .SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("radiiFile", &MyDetectorConstruction::SetRadiiFile,
+                              "Layer radii table (CSV: Z min, Inner radius, Outer radius)")
+        .SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("glue", &MyDetectorConstruction::SetGlue,
+                              "Place the glue layers of the composition table")
+        .SetDefaultValue("true")
+        .SetToBeBroadcasted(false);
+    fMessenger->DeclareMethod("air", &MyDetectorConstruction::SetAir,
+                              "Place the air gaps of the composition table (instead of vacuum)")
+        .SetDefaultValue("true")
+        .SetToBeBroadcasted(false);
+}
+
+MyDetectorConstruction::~MyDetectorConstruction() {
+    delete fMessenger;
+}
 
-MyDetectorConstruction::MyDetectorConstruction() {}
-MyDetectorConstruction::~MyDetectorConstruction() {}
+void MyDetectorConstruction::SetNesting(const G4String& nesting) {
+    GeometryNesting newNesting = GeometryNesting::Flat;
+    if (nesting == "envelope") {
+        newNesting = GeometryNesting::Envelope;
+    } else if (nesting == "cassette") {
+        newNesting = GeometryNesting::Cassette;
+    }
+    if (newNesting == fNesting) return;
+    fNesting = newNesting;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::SetFidelity(const G4String& fidelity) {
+    GeometryFidelity newFidelity = GeometryFidelity::Full;
+    if (fidelity == "merged") {
+        newFidelity = GeometryFidelity::Merged;
+    } else if (fidelity == "toy") {
+        newFidelity = GeometryFidelity::Toy;
+    }
+    if (newFidelity == fFidelity) return;
+    fFidelity = newFidelity;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::SetLayerFile(const G4String& fileName) {
+    fLayerFile = fileName;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::SetRadiiFile(const G4String& fileName) {
+    fRadiiFile = fileName;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::SetGlue(G4bool enable) {
+    if (enable == fWithGlue) return;
+    fWithGlue = enable;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::SetAir(G4bool enable) {
+    if (enable == fWithAir) return;
+    fWithAir = enable;
+    GeometryChanged();
+}
+
+void MyDetectorConstruction::GeometryChanged() {
+    // Already built: drop the volumes, the next run constructs them again
+    if (fConstructed) {
+        G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+    }
+}
 
 G4VPhysicalVolume* MyDetectorConstruction::Construct() {
-    G4NistManager* nist = G4NistManager::Instance();
+    G4Timer constructionTimer;
+    constructionTimer.Start();
 
     // ---------------------
     // World volume
     // ---------------------
-    G4Material* worldMat = nist->FindOrBuildMaterial("G4_Galactic");
+    G4Material* worldMat = fMaterials.Get("G4_Galactic");
     G4double worldSizeXY = 300.0*cm;
     G4double worldSizeZ = 600.0*cm;
     
@@ -43,758 +158,93 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
     );
 
     // ---------------------
-    // Materials
+    // Layer stack, from the composition and radii tables
     // ---------------------
-    G4Material* siMat = nist->FindOrBuildMaterial("G4_Si");
-    G4Material* cuMat = nist->FindOrBuildMaterial("G4_Cu");
-    G4Material* pbMat = nist->FindOrBuildMaterial("G4_Pb");
-    G4Material* airMat = nist->FindOrBuildMaterial("G4_AIR");
-    
-    G4Material* stainlessMat = new G4Material("StainlessSteel", 8.02*g/cm3, 2);
-    stainlessMat->AddElement(nist->FindOrBuildElement("Fe"), 0.70);
-    stainlessMat->AddElement(nist->FindOrBuildElement("Ni"), 0.30);
-    
-    G4Material* kaptonMat = new G4Material("Kapton", 1.11*g/cm3, 4);
-    kaptonMat->AddElement(nist->FindOrBuildElement("C"), 5);
-    kaptonMat->AddElement(nist->FindOrBuildElement("H"), 4);
-    kaptonMat->AddElement(nist->FindOrBuildElement("O"), 2);
-    kaptonMat->AddElement(nist->FindOrBuildElement("N"), 1);
-    
-    G4Material* pcbMat = new G4Material("PCB", 1.7*g/cm3, 3);
-    pcbMat->AddElement(nist->FindOrBuildElement("C"), 0.50);
-    pcbMat->AddElement(nist->FindOrBuildElement("H"), 0.30);
-    pcbMat->AddElement(nist->FindOrBuildElement("O"), 0.20);
-    
-    G4Material* glueMat = new G4Material("Glue", 1.3*g/cm3, 3);
-    glueMat->AddElement(nist->FindOrBuildElement("C"), 0.60);
-    glueMat->AddElement(nist->FindOrBuildElement("H"), 0.30);
-    glueMat->AddElement(nist->FindOrBuildElement("O"), 0.10);
+    G4Timer readTimer;
+    readTimer.Start();
+    std::vector<MaterialLayer> siliconLayers;
+    std::vector<MaterialLayer> nonSiliconLayers;
+    LayerStack::Options stackOptions = {fWithGlue, fWithAir};
+    if (fFidelity == GeometryFidelity::Toy) {
+        LayerStack::BuildToy(fMaterials, siliconLayers, nonSiliconLayers);
+    } else if (!LayerStack::Read(fLayerFile, fRadiiFile, stackOptions, fMaterials, siliconLayers, nonSiliconLayers)) {
+        G4Exception("MyDetectorConstruction::Construct", "HGCAL_Geometry", FatalException,
+                    "Cannot read the layer stack (see /hgcal/geometry/layerFile and radiiFile)");
+    }
+    if (fFidelity == GeometryFidelity::Merged) {
+        LayerStack::MergePassive(siliconLayers, nonSiliconLayers, fMaterials);
+    }
+    readTimer.Stop();
+    static const char* const kFidelityNames[] = {"full", "merged", "toy"};
+    G4cout << "Layer stack (" << kFidelityNames[static_cast<int>(fFidelity)] << "): " << siliconLayers.size()
+           << " sensors and " << nonSiliconLayers.size() << " passive layers, read in "
+           << readTimer.GetRealElapsed() * 1000. << " ms" << G4endl;
+
+    // Depth of the stack, to compare fidelity levels (merging keeps it)
+    G4double radiationLengths = 0.;
+    G4double interactionLengths = 0.;
+    for (const std::vector<MaterialLayer>* layers : {&siliconLayers, &nonSiliconLayers}) {
+        for (const auto& layer : *layers) {
+            G4double thickness = (layer.zMax - layer.zMin) * mm;
+            radiationLengths += thickness / layer.material->GetRadlen();
+            interactionLengths += thickness / layer.material->GetNuclearInterLength();
+        }
+    }
+    G4cout << "Layer stack depth: " << radiationLengths << " X0, " << interactionLengths << " lambda" << G4endl;
+
+    // Materials for the visualisation colours
+    G4Material* cuMat = fMaterials.Get("G4_Cu");
+    G4Material* pbMat = fMaterials.Get("G4_Pb");
+    G4Material* airMat = fMaterials.Get("G4_AIR");
+    G4Material* stainlessMat = fMaterials.Get("StainlessSteel");
+    G4Material* kaptonMat = fMaterials.Get("Kapton");
+    G4Material* pcbMat = fMaterials.Get("PCB");
+    G4Material* glueMat = fMaterials.Get("Glue");
 
     // ---------------------
-    // Silicon layers 
+    // Envelope of the stack (used by the generator to skip the vacuum)
     // ---------------------
+    fFrontFaceZ = DBL_MAX;
+    fMinInnerRadius = DBL_MAX;
+    for (const std::vector<MaterialLayer>* layers : {&siliconLayers, &nonSiliconLayers}) {
+        for (const auto& layer : *layers) {
+            if (layer.zMin * mm < fFrontFaceZ) {
+                fFrontFaceZ = layer.zMin * mm;
+                fFrontInnerRadius = layer.innerRadius * cm;
+                fFrontOuterRadius = layer.outerRadius * cm;
+            }
+            fMinInnerRadius = std::min(fMinInnerRadius, layer.innerRadius * cm);
+        }
+    }
+    ComputeCEESummary(siliconLayers, nonSiliconLayers);
 
-    std::vector<MaterialLayer> siliconLayers = {
-        {"Si_l1",   siMat,  3221.40,  3221.70, 151.9126, 31.8427, 1},
-        {"Si_l2",   siMat,  3231.34,  3231.64, 145.9057, 31.8427, 2},
-        {"Si_l3",   siMat,  3251.97,  3252.27, 151.9126, 31.8427, 3},
-        {"Si_l4",   siMat,  3261.91,  3262.21, 145.9057, 31.8427, 4},
-        {"Si_l5",   siMat,  3282.54,  3282.84, 151.9126, 31.8427, 5},
-        {"Si_l6",   siMat,  3292.48,  3292.78, 147.1386, 31.8427, 6},
-        {"Si_l7",   siMat,  3313.11,  3313.41, 151.9126, 31.8427, 7},
-        {"Si_l8",   siMat,  3323.05,  3323.35, 147.1386, 31.8427, 8},
-        {"Si_l9",   siMat,  3343.68,  3343.98, 155.4895, 31.8427, 9},
-        {"Si_l10",  siMat,  3353.62,  3353.92, 150.8288, 31.8427, 10},
-        {"Si_l11",  siMat,  3374.25,  3374.55, 155.4895, 31.8427, 11},
-        {"Si_l12",  siMat,  3384.19,  3384.49, 151.9126, 31.8427, 12},
-        {"Si_l13",  siMat,  3404.82,  3405.12, 155.4895, 31.8427, 13},
-        {"Si_l14",  siMat,  3414.76,  3415.06, 151.9126, 31.8427, 14},
-        {"Si_l15",  siMat,  3435.39,  3435.69, 157.8426, 31.8427, 15},
-        {"Si_l16",  siMat,  3445.33,  3445.63, 155.4895, 31.8427, 16},
-        {"Si_l17",  siMat,  3465.96,  3466.26, 157.8426, 31.8427, 17},
-        {"Si_l18",  siMat,  3475.90,  3476.20, 155.4895, 31.8427, 18},
-        {"Si_l19",  siMat,  3499.78,  3500.08, 158.5445, 31.8427, 19},
-        {"Si_l20",  siMat,  3509.72,  3510.02, 155.4895, 31.8427, 20},
-        {"Si_l21",  siMat,  3533.60,  3533.90, 160.7422, 31.8427, 21},
-        {"Si_l22",  siMat,  3543.54,  3543.84, 155.4895, 31.8427, 22},
-        {"Si_l23",  siMat,  3567.42,  3567.72, 162.2639, 31.8427, 23},
-        {"Si_l24",  siMat,  3577.36,  3577.66, 160.7422, 31.8427, 24},
-        {"Si_l25",  siMat,  3601.24,  3601.54, 162.9424, 31.8427, 25},
-        {"Si_l26",  siMat,  3611.18,  3611.48, 160.7422, 31.8427, 26},
-        {"Si_l27",  siMat,  3678.36,  3678.66, 164.1638, 35.3184, 27},
-        {"Si_l28",  siMat,  3741.41,  3741.71, 167.6860, 35.3184, 28},
-        {"Si_l29",  siMat,  3804.46,  3804.76, 168.9036, 35.3184, 29},
-        {"Si_l30",  siMat,  3867.51,  3867.81, 171.7523, 35.3184, 30},
-        {"Si_l31",  siMat,  3930.56,  3930.86, 175.8206, 35.3184, 31},
-        {"Si_l32",  siMat,  3993.61,  3993.91, 183.6329, 35.3184, 32},
-        {"Si_l33",  siMat,  4056.66,  4056.96, 191.4564, 35.3184, 33},
-        {"Si_l34",  siMat,  4119.71,  4120.01, 197.5766, 42.5782, 34},
-        {"Si_l35",  siMat,  4182.76,  4183.06, 206.3885, 42.5782, 35},
-        {"Si_l36",  siMat,  4245.81,  4246.11, 215.5940, 42.5782, 36},
-        {"Si_l37",  siMat,  4308.86,  4309.16, 215.5940, 42.5782, 37},
-        {"Si_l38",  siMat,  4391.11,  4391.41, 235.2550, 48.3669, 38},
-        {"Si_l39",  siMat,  4473.36,  4473.66, 245.7481, 48.3669, 39},
-        {"Si_l40",  siMat,  4555.61,  4555.91, 256.7096, 48.3669, 40},
-        {"Si_l41",  siMat,  4637.86,  4638.16, 256.7096, 48.3669, 41},
-        {"Si_l42",  siMat,  4720.11,  4720.41, 256.7096, 48.3669, 42},
-        {"Si_l43",  siMat,  4802.36,  4802.66, 256.7096, 48.3669, 43},
-        {"Si_l44",  siMat,  4884.61,  4884.91, 256.7096, 48.3669, 44},
-        {"Si_l45",  siMat,  4966.86,  4967.16, 256.7096, 48.3669, 45},
-        {"Si_l46",  siMat,  5049.11,  5049.41, 256.7096, 48.3669, 46},
-        {"Si_l47",  siMat,  5131.36,  5131.66, 256.7096, 48.3669, 47}        
-    };
-
+    // ---------------------
+    // Regions with their own production cuts, changed at run time with
+    // /run/setCutForRegion <region> <cut>; all start from the 0.7 mm default
+    // ---------------------
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    G4Region* siliconRegion = regionStore->FindOrCreateRegion("SiliconSensors");
+    G4Region* absorberRegion = regionStore->FindOrCreateRegion("EMAbsorbers");
+    G4Region* servicesRegion = regionStore->FindOrCreateRegion("Services");
+    for (G4Region* region : {siliconRegion, absorberRegion, servicesRegion}) {
+        if (!region->GetProductionCuts()) {
+            G4ProductionCuts* cuts = new G4ProductionCuts();
+            cuts->SetProductionCut(0.7 * mm);
+            region->SetProductionCuts(cuts);
+        }
+    }
 
     // ---------------------
-    // Non-silicon layers 
+    // Mother volumes of the layers (flat: the world)
     // ---------------------
-    std::vector<MaterialLayer> nonSiliconLayers = {
-   	{"Cu_l0_pre1", cuMat, 3210.5, 3210.6, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l0_pre2", stainlessMat, 3210.6, 3210.9, 151.9126, 31.8427, -1},
-    	//{"glue_l0_pre3", glueMat, 3210.9, 3210.95, 151.9126, 31.8427, -1},
-    	{"Lead_l0_pre4", pbMat, 3210.95, 3213.72, 151.9126, 31.8427, -1},
-    	//{"glue_l0_pre5", glueMat, 3213.72, 3213.77, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l0_pre6", stainlessMat, 3213.77, 3214.07, 151.9126, 31.8427, -1},
-    	{"Cu_l0_pre7", cuMat, 3214.07, 3214.17, 151.9126, 31.8427, -1},
-    	//{"Air_l0_pre8", airMat, 3214.17, 3214.395, 151.9126, 31.8427, -1},
-    	{"PCB_l0_pre9", pcbMat, 3214.395, 3215.995, 151.9126, 31.8427, -1},
-    	//{"Airelectronics_l0_pre10", airMat, 3215.995, 3219.725, 151.9126, 31.8427, -1},
-    	{"PCBHexaboard_l0_pre11", pcbMat, 3219.725, 3221.325, 151.9126, 31.8427, -1},
-    	//{"glue_l0_pre12", glueMat, 3221.325, 3221.4, 151.9126, 31.8427, -1},
-
-    	//{"glue_l1_post1", glueMat, 3221.7, 3221.765, 151.9126, 31.8427, -1},
-    	{"kapton_l1_pre1", kaptonMat, 3221.765, 3222.03, 151.9126, 31.8427, -1},
-    	//{"glue_l1_pre2", glueMat, 3222.03, 3222.095, 151.9126, 31.8427, -1},
-    	{"CuW_l1_pre3", cuMat, 3222.095, 3223.495, 151.9126, 31.8427, -1},
-    	{"CoolingplateCu_l1_pre4", cuMat, 3223.495, 3229.545, 151.9126, 31.8427, -1},
-    	{"CuW_l1_pre5", cuMat, 3229.545, 3230.945, 151.9126, 31.8427, -1},
-    	//{"glue_l1_pre6", glueMat, 3230.945, 3231.01, 151.9126, 31.8427, -1},
-    	{"kapton_l1_pre7", kaptonMat, 3231.01, 3231.275, 151.9126, 31.8427, -1},
-    	//{"glue_l1_pre8", glueMat, 3231.275, 3231.34, 151.9126, 31.8427, -1},
-
-    	//{"glue_l2_post1", glueMat, 3231.64, 3231.715, 145.9057, 31.8427, -1},
-    	{"PCBHexaboard_l2_pre1", pcbMat, 3231.715, 3233.315, 145.9057, 31.8427, -1},
-    	//{"Airelectronics_l2_pre2", airMat, 3233.315, 3237.045, 145.9057, 31.8427, -1},
-    	{"PCB_l2_pre3", pcbMat, 3237.045, 3238.645, 145.9057, 31.8427, -1},
-    	//{"Air_l2_pre4", airMat, 3238.645, 3238.87, 145.9057, 31.8427, -1},
-    	{"Cu_l2_pre5", cuMat, 3238.87, 3238.97, 145.9057, 31.8427, -1},
-    	{"StainlessSteel_l2_pre6", stainlessMat, 3238.97, 3239.27, 145.9057, 31.8427, -1},
-    	//{"glue_l2_pre7", glueMat, 3239.27, 3239.32, 145.9057, 31.8427, -1},
-    	{"Lead_l2_pre8", pbMat, 3239.32, 3244.29, 145.9057, 31.8427, -1},
-    	//{"glue_l2_pre9", glueMat, 3244.29, 3244.34, 145.9057, 31.8427, -1},
-    	{"StainlessSteel_l2_pre10", stainlessMat, 3244.34, 3244.64, 145.9057, 31.8427, -1},
-    	{"Cu_l2_pre11", cuMat, 3244.64, 3244.74, 145.9057, 31.8427, -1},
-    	//{"Air_l2_pre12", airMat, 3244.74, 3244.965, 145.9057, 31.8427, -1},
-    	{"PCB_l2_pre13", pcbMat, 3244.965, 3246.565, 145.9057, 31.8427, -1},
-    	//{"Airelectronics_l2_pre14", airMat, 3246.565, 3250.295, 145.9057, 31.8427, -1},
-    	{"PCBHexaboard_l2_pre15", pcbMat, 3250.295, 3251.895, 145.9057, 31.8427, -1},
-    	//{"glue_l2_pre16", glueMat, 3251.895, 3251.97, 145.9057, 31.8427, -1},
-	
-    	//{"glue_l3_post1", glueMat, 3252.27, 3252.335, 151.9126, 31.8427, -1},
-    	{"kapton_l3_pre1", kaptonMat, 3252.335, 3252.6, 151.9126, 31.8427, -1},
-    	//{"glue_l3_pre2", glueMat, 3252.6, 3252.665, 151.9126, 31.8427, -1},
-    	{"CuW_l3_pre3", cuMat, 3252.665, 3254.065, 151.9126, 31.8427, -1},
-    	{"CoolingplateCu_l3_pre4", cuMat, 3254.065, 3260.115, 151.9126, 31.8427, -1},
-    	{"CuW_l3_pre5", cuMat, 3260.115, 3261.515, 151.9126, 31.8427, -1},
-    	//{"glue_l3_pre6", glueMat, 3261.515, 3261.58, 151.9126, 31.8427, -1},
-    	{"kapton_l3_pre7", kaptonMat, 3261.58, 3261.845, 151.9126, 31.8427, -1},
-    	//{"glue_l3_pre8", glueMat, 3261.845, 3261.91, 151.9126, 31.8427, -1},
-	
-    	//{"glue_l4_post1", glueMat, 3262.21, 3262.285, 145.9057, 31.8427, -1},
-    	{"PCBHexaboard_l4_pre1", pcbMat, 3262.285, 3263.885, 145.9057, 31.8427, -1},
-    	//{"Airelectronics_l4_pre2", airMat, 3263.885, 3267.615, 145.9057, 31.8427, -1},
-    	{"PCB_l4_pre3", pcbMat, 3267.615, 3269.215, 145.9057, 31.8427, -1},
-    	//{"Air_l4_pre4", airMat, 3269.215, 42.5782, 3269.44, 145.9057, 31.8427, -1},
-    	{"Cu_l4_pre5", cuMat, 3269.44, 3269.54, 145.9057, 31.8427, -1},
-    	{"StainlessSteel_l4_pre6", stainlessMat, 3269.54, 3269.84, 145.9057, 31.8427, -1},
-    	//{"glue_l4_pre7", glueMat, 3269.84, 3269.89, 145.9057, 31.8427, -1},
-    	{"Lead_l4_pre8", pbMat, 3269.89, 3274.86, 145.9057, 31.8427, -1},
-    	//{"glue_l4_pre9", glueMat, 3274.86, 3274.91, 145.9057, 31.8427, -1},
-    	{"StainlessSteel_l4_pre10", stainlessMat, 3274.91, 3275.21, 145.9057, 31.8427, -1},
-    	{"Cu_l4_pre11", cuMat, 3275.21, 3275.31, 145.9057, 31.8427, -1},
-    	//{"Air_l4_pre12", airMat, 3275.31, 3275.535, 145.9057, 31.8427, -1},
-    	{"PCB_l4_pre13", pcbMat, 3275.535, 3277.135, 145.9057, 31.8427, -1},
-    	//{"Airelectronics_l4_pre14", airMat, 3277.135, 3280.865, 145.9057, 31.8427, -1},
-    	{"PCBHexaboard_l4_pre15", pcbMat, 3280.865, 3282.465, 145.9057, 31.8427, -1},
-    	//{"glue_l4_pre16", glueMat, 3282.465, 3282.54, 145.9057, 31.8427, -1},
-
-    	//{"glue_l5_post1", glueMat, 3282.84, 3282.905, 151.9126, 31.8427, -1},
-    	{"kapton_l5_pre1", kaptonMat, 3282.905, 3283.17, 151.9126, 31.8427, -1},
-    	//{"glue_l5_pre2", glueMat, 3283.17, 3283.235, 151.9126, 31.8427, -1},
-    	{"CuW_l5_pre3", cuMat, 3283.235, 3284.635, 151.9126, 31.8427, -1},
-    	{"CoolingplateCu_l5_pre4", cuMat, 3284.635, 3290.685, 151.9126, 31.8427, -1},
-    	{"CuW_l5_pre5", cuMat, 3290.685, 3292.085, 151.9126, 31.8427, -1},
-    	//{"glue_l5_pre6", glueMat, 3292.085, 3292.15, 151.9126, 31.8427, -1},
-    	{"kapton_l5_pre7", kaptonMat, 3292.15, 3292.415, 151.9126, 31.8427, -1},
-    	//{"glue_l5_pre8", glueMat, 3292.415, 3292.48, 151.9126, 31.8427, -1},
-
-    	//{"glue_l6_post1", glueMat, 3292.78, 3292.855, 147.1386, 31.8427, -1},
-    	{"PCBHexaboard_l6_pre1", pcbMat, 3292.855, 3294.455, 147.1386, 31.8427, -1},
-    	//{"Airelectronics_l6_pre2", airMat, 3294.455, 3298.185, 147.1386, 31.8427, -1},
-    	{"PCB_l6_pre3", pcbMat, 3298.185, 3299.785, 147.1386, 31.8427, -1},
-    	//{"Air_l6_pre4", airMat, 3299.785, 3300.01, 147.1386, 31.8427, -1},
-    	{"Cu_l6_pre5", cuMat, 3300.01, 3300.11, 147.1386, 31.8427, -1},
-    	{"StainlessSteel_l6_pre6", stainlessMat, 3300.11, 3300.41, 147.1386, 31.8427, -1},
-    	//{"glue_l6_pre7", glueMat, 3300.41, 3300.46, 147.1386, 31.8427, -1},
-    	{"Lead_l6_pre8", pbMat, 3300.46, 3305.43, 147.1386, 31.8427, -1},
-    	//{"glue_l6_pre9", glueMat, 3305.43, 3305.48, 147.1386, 31.8427, -1},
-    	{"StainlessSteel_l6_pre10", stainlessMat, 3305.48, 3305.78, 147.1386, 31.8427, -1},
-    	{"Cu_l6_pre11", cuMat, 3305.78, 3305.88, 147.1386, 31.8427, -1},
-    	//{"Air_l6_pre12", airMat, 3305.88, 3306.105, 147.1386, 31.8427, -1},
-    	{"PCB_l6_pre13", pcbMat, 3306.105, 3307.705, 147.1386, 31.8427, -1},
-    	//{"Airelectronics_l6_pre14", airMat, 3307.705, 3311.435, 147.1386, 31.8427, -1},
-    	{"PCBHexaboard_l6_pre15", pcbMat, 3311.435, 3313.035, 147.1386, 31.8427, -1},
-    	//{"glue_l6_pre16", glueMat, 3313.035, 3313.11, 147.1386, 31.8427, -1},
-
-    	//{"glue_l7_post1", glueMat, 3313.41, 3313.475, 151.9126, 31.8427, -1},
-    	{"kapton_l7_pre1", kaptonMat, 3313.475, 3313.74, 151.9126, 31.8427, -1},
-    	//{"glue_l7_pre2", glueMat, 3313.74, 3313.805, 151.9126, 31.8427, -1},
-    	{"CuW_l7_pre3", cuMat, 3313.805, 3315.205, 151.9126, 31.8427, -1},
-    	{"CoolingplateCu_l7_pre4", cuMat, 3315.205, 3321.255, 151.9126, 31.8427, -1},
-    	{"CuW_l7_pre5", cuMat, 3321.255, 3322.655, 151.9126, 31.8427, -1},
-    	//{"glue_l7_pre6", glueMat, 3322.655, 3322.72, 151.9126, 31.8427, -1},
-    	{"kapton_l7_pre7", kaptonMat, 3322.72, 3322.985, 151.9126, 31.8427, -1},
-    	//{"glue_l7_pre8", glueMat, 3322.985, 3323.05, 151.9126, 31.8427, -1},
-
-    	//{"glue_l8_post1", glueMat, 3323.35, 3323.425, 147.1386, 31.8427, -1},
-    	{"PCBHexaboard_l8_pre1", pcbMat, 3323.425, 3325.025, 147.1386, 31.8427, -1},
-    	//{"Airelectronics_l8_pre2", airMat, 3325.025, 3328.755, 147.1386, 31.8427, -1},
-    	{"PCB_l8_pre3", pcbMat, 3328.755, 3330.355, 147.1386, 31.8427, -1},
-    	//{"Air_l8_pre4", airMat, 3330.355, 3330.58, 147.1386, 31.8427, -1},
-    	{"Cu_l8_pre5", cuMat, 3330.58, 3330.68, 147.1386, 31.8427, -1},
-    	{"StainlessSteel_l8_pre6", stainlessMat, 3330.68, 3330.98, 147.1386, 31.8427, -1},
-    	//{"glue_l8_pre7", glueMat, 3330.98, 3331.03, 147.1386, 31.8427, -1},
-    	{"Lead_l8_pre8", pbMat, 3331.03, 3336.0, 147.1386, 31.8427, -1},
-    	//{"glue_l8_pre9", glueMat, 3336.0, 3336.05, 147.1386, 31.8427, -1},
-    	{"StainlessSteel_l8_pre10", stainlessMat, 3336.05, 3336.35, 147.1386, 31.8427, -1},
-    	{"Cu_l8_pre11", cuMat, 3336.35, 3336.45, 147.1386, 31.8427, -1},
-    	//{"Air_l8_pre12", airMat, 3336.45, 3336.675, 147.1386, 31.8427, -1},
-    	{"PCB_l8_pre13", pcbMat, 3336.675, 3338.275, 147.1386, 31.8427, -1},
-    	//{"Airelectronics_l8_pre14", airMat, 3338.275, 3342.005, 147.1386, 31.8427, -1},
-    	{"PCBHexaboard_l8_pre15", pcbMat, 3342.005, 3343.605, 147.1386, 31.8427, -1},
-    	//{"glue_l8_pre16", glueMat, 3343.605, 3343.68, 147.1386, 31.8427, -1},
-
-    	//{"glue_l9_post1", glueMat, 3343.98, 3344.045, 155.4895, 31.8427, -1},
-    	{"kapton_l9_pre1", kaptonMat, 3344.045, 3344.31, 155.4895, 31.8427, -1},
-   	//{"glue_l9_pre2", glueMat, 3344.31, 3344.375, 155.4895, 31.8427, -1},
-    	{"CuW_l9_pre3", cuMat, 3344.375, 3345.775, 155.4895, 31.8427, -1},
-    	{"CoolingplateCu_l9_pre4", cuMat, 3345.775, 3351.825, 155.4895, 31.8427, -1},
-    	{"CuW_l9_pre5", cuMat, 3351.825, 3353.225, 155.4895, 31.8427, -1},
-    	//{"glue_l9_pre6", glueMat, 3353.225, 3353.29, 155.4895, 31.8427, -1},
-    	{"kapton_l9_pre7", kaptonMat, 3353.29, 3353.555, 155.4895, 31.8427, -1},
-    	//{"glue_l9_pre8", glueMat, 3353.555, 3353.62, 155.4895, 31.8427, -1},
-
-    	//{"glue_l10_post1", glueMat, 3353.92, 3353.995, 150.8288, 31.8427, -1},
-    	{"PCBHexaboard_l10_pre1", pcbMat, 3353.995, 3355.595, 150.8288, 31.8427, -1},
-    	//{"Airelectronics_l10_pre2", airMat, 3355.595, 3359.325, 150.8288, 31.8427, -1},
-    	{"PCB_l10_pre3", pcbMat, 3359.325, 3360.925, 150.8288, 31.8427, -1},
-    	//{"Air_l10_pre4", airMat, 3360.925, 3361.15, 150.8288, 31.8427, -1},
-    	{"Cu_l10_pre5", cuMat, 3361.15, 3361.25, 150.8288, 31.8427, -1},
-    	{"StainlessSteel_l10_pre6", stainlessMat, 3361.25, 3361.55, 150.8288, 31.8427, -1},
-    	//{"glue_l10_pre7", glueMat, 3361.55, 3361.6, 150.8288, 31.8427, -1},
-    	{"Lead_l10_pre8", pbMat, 3361.6, 3366.57, 150.8288, 31.8427, -1},
-    	//{"glue_l10_pre9", glueMat, 3366.57, 3366.62, 150.8288, 31.8427, -1},
-    	{"StainlessSteel_l10_pre10", stainlessMat, 3366.62, 3366.92, 150.8288, 31.8427, -1},
-    	{"Cu_l10_pre11", cuMat, 3366.92, 3367.02, 150.8288, 31.8427, -1},
-    	//{"Air_l10_pre12", airMat, 3367.02, 3367.245,150.8288, 31.8427, -1},
-    	{"PCB_l10_pre13", pcbMat, 3367.245, 3368.845, 150.8288, 31.8427, -1},
-    	//{"Airelectronics_l10_pre14", airMat, 3368.845, 3372.575, 150.8288, 31.8427, -1},
-    	{"PCBHexaboard_l10_pre15", pcbMat, 3372.575, 3374.175, 150.8288, 31.8427, -1},
-    	//{"glue_l10_pre16", glueMat, 3374.175, 3374.25, 150.8288, 31.8427, -1},
-
-    	//{"glue_l11_post1", glueMat, 3374.55, 3374.615, 155.4895, 31.8427, -1},
-    	{"kapton_l11_pre1", kaptonMat, 3374.615, 3374.88, 155.4895, 31.8427, -1},
-    	//{"glue_l11_pre2", glueMat, 3374.88, 3374.945, 155.4895, 31.8427, -1},
-    	{"CuW_l11_pre3", cuMat, 3374.945, 3376.345, 155.4895, 31.8427, -1},
-    	{"CoolingplateCu_l11_pre4", cuMat, 3376.345, 3382.395, 155.4895, 31.8427, -1},
-    	{"CuW_l11_pre5", cuMat, 3382.395, 3383.795, 155.4895, 31.8427, -1},
-    	//{"glue_l11_pre6", glueMat, 3383.795, 3383.86, 155.4895, 31.8427, -1},
-    	{"kapton_l11_pre7", kaptonMat, 3383.86, 3384.125, 155.4895, 31.8427, -1},
-    	//{"glue_l11_pre8", glueMat, 3384.125, 3384.19, 155.4895, 31.8427, -1},
-
-    	//{"glue_l12_post1", glueMat, 3384.49, 3384.565, 151.9126, 31.8427, -1},
-    	{"PCBHexaboard_l12_pre1", pcbMat, 3384.565, 3386.165, 151.9126, 31.8427, -1},
-    	//{"Airelectronics_l12_pre2", airMat, 3386.165, 3389.895, 151.9126, 31.8427, -1},
-    	{"PCB_l12_pre3", pcbMat, 3389.895, 3391.495, 151.9126, 31.8427, -1},
-    	//{"Air_l12_pre4", airMat, 3391.495, 3391.72, 151.9126, 31.8427, -1},
-    	{"Cu_l12_pre5", cuMat, 3391.72, 3391.82, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l12_pre6", stainlessMat, 3391.82, 3392.12, 151.9126, 31.8427, -1},
-    	//{"glue_l12_pre7", glueMat, 3392.12, 3392.17, 151.9126, 31.8427, -1},
-    	{"Lead_l12_pre8", pbMat, 3392.17, 3397.14, 151.9126, 31.8427, -1},
-    	//{"glue_l12_pre9", glueMat, 3397.14, 3397.19, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l12_pre10", stainlessMat, 3397.19, 3397.49, 151.9126, 31.8427, -1},
-    	{"Cu_l12_pre11", cuMat, 3397.49, 3397.59, 151.9126, 31.8427, -1},
-    	//{"Air_l12_pre12", airMat, 3397.59, 3397.815, 151.9126, 31.8427, -1},
-    	{"PCB_l12_pre13", pcbMat, 3397.815, 3399.415, 151.9126, 31.8427, -1},
-    	//{"Airelectronics_l12_pre14", airMat, 3399.415, 3403.145, 151.9126, 31.8427, -1},
-    	{"PCBHexaboard_l12_pre15", pcbMat, 3403.145, 3404.745, 151.9126, 31.8427, -1},
-    	//{"glue_l12_pre16", glueMat, 3404.745, 3404.82, 151.9126, 31.8427, -1},
-
-    	//{"glue_l13_post1", glueMat, 3405.12, 3405.185, 155.4895, 31.8427, -1},
-    	{"kapton_l13_pre1", kaptonMat, 3405.185, 3405.45, 155.4895, 31.8427, -1},
-    	//{"glue_l13_pre2", glueMat, 3405.45, 3405.515, 155.4895, 31.8427, -1},
-    	{"CuW_l13_pre3", cuMat, 3405.515, 3406.915, 155.4895, 31.8427, -1},
-    	{"CoolingplateCu_l13_pre4", cuMat, 3406.915, 3412.965, 155.4895, 31.8427, -1},
-    	{"CuW_l13_pre5", cuMat, 3412.965, 3414.365, 155.4895, 31.8427, -1},
-    	//{"glue_l13_pre6", glueMat, 3414.365, 3414.43, 155.4895, 31.8427, -1},
-    	{"kapton_l13_pre7", kaptonMat, 3414.43, 3414.695, 155.4895, 31.8427, -1},
-    	//{"glue_l13_pre8", glueMat, 3414.695, 3414.76, 155.4895, 31.8427, -1},
-
-    	//{"glue_l14_post1", glueMat, 3415.06, 3415.135, 151.9126, 31.8427, -1},
-    	{"PCBHexaboard_l14_pre1", pcbMat, 3415.135, 3416.735, 151.9126, 31.8427, -1},
-    	//{"Airelectronics_l14_pre2", airMat, 3416.735, 3420.465, 151.9126, 31.8427, -1},
-    	{"PCB_l14_pre3", pcbMat, 3420.465, 3422.065, 151.9126, 31.8427, -1},
-    	//{"Air_l14_pre4", airMat, 3422.065, 3422.29, 151.9126, 31.8427, -1},
-    	{"Cu_l14_pre5", cuMat, 3422.29, 3422.39, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l14_pre6", stainlessMat, 3422.39, 3422.69, 151.9126, 31.8427, -1},
-    	//{"glue_l14_pre7", glueMat, 3422.69, 3422.74, 151.9126, 31.8427, -1},
-    	{"Lead_l14_pre8", pbMat, 3422.74, 3427.71, 151.9126, 31.8427, -1},
-    	//{"glue_l14_pre9", glueMat, 3427.71, 3427.76, 151.9126, 31.8427, -1},
-    	{"StainlessSteel_l14_pre10", stainlessMat, 3427.76, 3428.06, 151.9126, 31.8427, -1},
-    	{"Cu_l14_pre11", cuMat, 3428.06, 3428.16, 151.9126, 31.8427, -1},
-    	//{"Air_l14_pre12", airMat, 3428.16, 3428.385, 151.9126, 31.8427, -1},
-    	{"PCB_l14_pre13", pcbMat, 3428.385, 3429.985, 151.9126, 31.8427, -1},
-    	//{"Airelectronics_l14_pre14", airMat, 3429.985, 3433.715, 151.9126, 31.8427, -1},
-    	{"PCBHexaboard_l14_pre15", pcbMat, 3433.715, 3435.315, 151.9126, 31.8427, -1},
-    	//{"glue_l14_pre16", glueMat, 3435.315, 3435.39, 151.9126, 31.8427, -1},
-
-    	//{"glue_l15_post1", glueMat, 3435.69, 3435.755, 157.8426, 31.8427, -1},
-    	{"kapton_l15_pre1", kaptonMat, 3435.755, 3436.02, 157.8426, 31.8427, -1},
-    	//{"glue_l15_pre2", glueMat, 3436.02, 3436.085, 157.8426, 31.8427, -1},
-    	{"CuW_l15_pre3", cuMat, 3436.085, 3437.485, 157.8426, 31.8427, -1},
-    	{"CoolingplateCu_l15_pre4", cuMat, 3437.485, 3443.535, 157.8426, 31.8427, -1},
-    	{"CuW_l15_pre5", cuMat, 3443.535, 3444.935, 157.8426, 31.8427, -1},
-    	//{"glue_l15_pre6", glueMat, 3444.935, 3445.0, 157.8426, 31.8427, -1},
-    	{"kapton_l15_pre7", kaptonMat, 3445.0, 3445.265, 157.8426, 31.8427, -1},
-    	//{"glue_l15_pre8", glueMat, 3445.265, 3445.33, 157.8426, 31.8427, -1},
-
-    	//{"glue_l16_post1", glueMat, 3445.63, 3445.705, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l16_pre1", pcbMat, 3445.705, 3447.305, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l16_pre2", airMat, 3447.305, 3451.035, 155.4895, 31.8427, -1},
-    	{"PCB_l16_pre3", pcbMat, 3451.035, 3452.635, 155.4895, 31.8427, -1},
-    	//{"Air_l16_pre4", airMat, 3452.635, 3452.86, 155.4895, 31.8427, -1},
-    	{"Cu_l16_pre5", cuMat, 3452.86, 3452.96, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l16_pre6", stainlessMat, 3452.96, 3453.26, 155.4895, 31.8427, -1},
-    	//{"glue_l16_pre7", glueMat, 3453.26, 3453.31, 155.4895, 31.8427, -1},
-    	{"Lead_l16_pre8", pbMat, 3453.31, 3458.28, 155.4895, 31.8427, -1},
-    	//{"glue_l16_pre9", glueMat, 3458.28, 3458.33, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l16_pre10", stainlessMat, 3458.33, 3458.63, 155.4895, 31.8427, -1},
-    	{"Cu_l16_pre11", cuMat, 3458.63, 3458.73, 155.4895, 31.8427, -1},
-    	//{"Air_l16_pre12", airMat, 3458.73, 3458.955, 155.4895, 31.8427, -1},
-    	{"PCB_l16_pre13", pcbMat, 3458.955, 3460.555, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l16_pre14", airMat, 3460.555, 3464.285, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l16_pre15", pcbMat, 3464.285, 3465.885, 155.4895, 31.8427, -1},
-    	//{"glue_l16_pre16", glueMat, 3465.885, 3465.96, 155.4895, 31.8427, -1},
-
-    	//{"glue_l17_post1", glueMat, 3466.26, 3466.325, 157.8426, 31.8427, -1},
-    	{"kapton_l17_pre1", kaptonMat, 3466.325, 3466.59, 157.8426, 31.8427, -1},
-    	//{"glue_l17_pre2", glueMat, 3466.59, 3466.655, 157.8426, 31.8427, -1},
-    	{"CuW_l17_pre3", cuMat, 3466.655, 3468.055, 157.8426, 31.8427, -1},
-    	{"CoolingplateCu_l17_pre4", cuMat, 3468.055, 3474.105, 157.8426, 31.8427, -1},
-    	{"CuW_l17_pre5", cuMat, 3474.105, 3475.505, 157.8426, 31.8427, -1},
-    	//{"glue_l17_pre6", glueMat, 3475.505, 3475.57, 157.8426, 31.8427, -1},
-    	{"kapton_l17_pre7", kaptonMat, 3475.57, 3475.835, 157.8426, 31.8427, -1},
-    	//{"glue_l17_pre8", glueMat, 3475.835, 3475.9, 157.8426, 31.8427, -1},
-
-    	//{"glue_l18_post1", glueMat, 3476.2, 3476.275, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l18_pre1", pcbMat, 3476.275, 3477.875, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l18_pre2", airMat, 3477.875, 3481.605, 155.4895, 31.8427, -1},
-    	{"PCB_l18_pre3", pcbMat, 3481.605, 3483.205, 155.4895, 31.8427, -1},
-    	//{"Air_l18_pre4", airMat, 3483.205, 3483.43, 155.4895, 31.8427, -1},
-    	{"Cu_l18_pre5", cuMat, 3483.43, 3483.53, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l18_pre6", stainlessMat, 3483.53, 3483.83, 155.4895, 31.8427, -1},
-    	//{"glue_l18_pre7", glueMat, 3483.83, 3483.88, 155.4895, 31.8427, -1},
-    	{"Lead_l18_pre8", pbMat, 3483.88, 3492.1, 155.4895, 31.8427, -1},
-    	//{"glue_l18_pre9", glueMat, 3492.1, 3492.15, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l18_pre10", stainlessMat, 3492.15, 3492.45, 155.4895, 31.8427, -1},
-    	{"Cu_l18_pre11", cuMat, 3492.45, 3492.55, 155.4895, 31.8427, -1},
-    	//{"Air_l18_pre12", airMat, 3492.55, 3492.775, 155.4895, 31.8427, -1},
-    	{"PCB_l18_pre13", pcbMat, 3492.775, 3494.375, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l18_pre14", airMat, 3494.375, 3498.105, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l18_pre15", pcbMat, 3498.105, 3499.705, 155.4895, 31.8427, -1},
-    	//{"glue_l18_pre16", glueMat, 3499.705, 3499.78, 155.4895, 31.8427, -1},
-
-    	//{"glue_l19_post1", glueMat, 3500.08, 3500.145, 158.5445, 31.8427, -1},
-    	{"kapton_l19_pre1", kaptonMat, 3500.145, 3500.41, 158.5445, 31.8427, -1},
-    	//{"glue_l19_pre2", glueMat, 3500.41, 3500.475, 158.5445, 31.8427, -1},
-    	{"CuW_l19_pre3", cuMat, 3500.475, 3501.875, 158.5445, 31.8427, -1},
-    	{"CoolingplateCu_l19_pre4", cuMat, 3501.875, 3507.925, 158.5445, 31.8427, -1},
-    	{"CuW_l19_pre5", cuMat, 3507.925, 3509.325, 158.5445, 31.8427, -1},
-    	//{"glue_l19_pre6", glueMat, 3509.325, 3509.39, 158.5445, 31.8427, -1},
-    	{"kapton_l19_pre7", kaptonMat, 3509.39, 3509.655, 158.5445, 31.8427, -1},
-    	//{"glue_l19_pre8", glueMat, 3509.655, 3509.72, 158.5445, 31.8427, -1},
-
-    	//{"glue_l20_post1", glueMat, 3510.02, 3510.095, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l20_pre1", pcbMat, 3510.095, 3511.695, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l20_pre2", airMat, 3511.695, 3515.425, 155.4895, 31.8427, -1},
-    	{"PCB_l20_pre3", pcbMat, 3515.425, 3517.025, 155.4895, 31.8427, -1},
-    	//{"Air_l20_pre4", airMat, 3517.025, 3517.25, 155.4895, 31.8427, -1},
-    	{"Cu_l20_pre5", cuMat, 3517.25, 3517.35, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l20_pre6", stainlessMat, 3517.35, 3517.65, 155.4895, 31.8427, -1},
-    	//{"glue_l20_pre7", glueMat, 3517.65, 3517.7, 155.4895, 31.8427, -1},
-    	{"Lead_l20_pre8", pbMat, 3517.7, 3525.92, 155.4895, 31.8427, -1},
-    	//{"glue_l20_pre9", glueMat, 3525.92, 3525.97, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l20_pre10", stainlessMat, 3525.97, 3526.27, 155.4895, 31.8427, -1},
-    	{"Cu_l20_pre11", cuMat, 3526.27, 3526.37, 155.4895, 31.8427, -1},
-    	//{"Air_l20_pre12", airMat, 3526.37, 3526.595, 155.4895, 31.8427, -1},
-    	{"PCB_l20_pre13", pcbMat, 3526.595, 3528.195, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l20_pre14", airMat, 3528.195, 3531.925, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l20_pre15", pcbMat, 3531.925, 3533.525, 155.4895, 31.8427, -1},
-    	//{"glue_l20_pre16", glueMat, 3533.525, 3533.6, 155.4895, 31.8427, -1},
-
-    	//{"glue_l21_post1", glueMat, 3533.9, 3533.965, 160.7422, 31.8427, -1},
-    	{"kapton_l21_pre1", kaptonMat, 3533.965, 3534.23, 160.7422, 31.8427, -1},
-    	//{"glue_l21_pre2", glueMat, 3534.23, 3534.295, 160.7422, 31.8427, -1},
-    	{"CuW_l21_pre3", cuMat, 3534.295, 3535.695, 160.7422, 31.8427, -1},
-    	{"CoolingplateCu_l21_pre4", cuMat, 3535.695, 3541.745, 160.7422, 31.8427, -1},
-    	{"CuW_l21_pre5", cuMat, 3541.745, 3543.145, 160.7422, 31.8427, -1},
-    	//{"glue_l21_pre6", glueMat, 3543.145, 3543.21, 160.7422, 31.8427, -1},
-    	{"kapton_l21_pre7", kaptonMat, 3543.21, 3543.475, 160.7422, 31.8427, -1},
-    	//{"glue_l21_pre8", glueMat, 3543.475, 3543.54, 160.7422, 31.8427, -1},
-
-    	//{"glue_l22_post1", glueMat, 3543.84, 3543.915, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l22_pre1", pcbMat, 3543.915, 3545.515, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l22_pre2", airMat, 3545.515, 3549.245.0, 42.5782, 155.4895, 31.8427, -1},
-    	{"PCB_l22_pre3", pcbMat, 3549.245, 3550.845, 155.4895, 31.8427, -1},
-    	//{"Air_l22_pre4", airMat, 3550.845, 3551.07, 155.4895, 31.8427, -1},
-    	{"Cu_l22_pre5", cuMat, 3551.07, 3551.17, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l22_pre6", stainlessMat, 3551.17, 3551.47, 155.4895, 31.8427, -1},
-    	//{"glue_l22_pre7", glueMat, 3551.47, 3551.52, 155.4895, 31.8427, -1},
-    	{"Lead_l22_pre8", pbMat, 3551.52, 3559.74, 155.4895, 31.8427, -1},
-    	//{"glue_l22_pre9", glueMat, 3559.74, 3559.79, 155.4895, 31.8427, -1},
-    	{"StainlessSteel_l22_pre10", stainlessMat, 3559.79, 3560.09, 155.4895, 31.8427, -1},
-    	{"Cu_l22_pre11", cuMat, 3560.09, 3560.19, 155.4895, 31.8427, -1},
-    	//{"Air_l22_pre12", airMat, 3560.19, 3560.415, 155.4895, 31.8427, -1},
-    	{"PCB_l22_pre13", pcbMat, 3560.415, 3562.015, 155.4895, 31.8427, -1},
-    	//{"Airelectronics_l22_pre14", airMat, 3562.015, 3565.745, 155.4895, 31.8427, -1},
-    	{"PCBHexaboard_l22_pre15", pcbMat, 3565.745, 3567.345, 155.4895, 31.8427, -1},
-    	//{"glue_l22_pre16", glueMat, 3567.345, 3567.42, 155.4895, 31.8427, -1},
-
-    	//{"glue_l23_post1", glueMat, 3567.72, 3567.785, 162.2639, 31.8427, -1},
-    	{"kapton_l23_pre1", kaptonMat, 3567.785, 3568.05, 162.2639, 31.8427, -1},
-    	//{"glue_l23_pre2", glueMat, 3568.05, 3568.115, 162.2639, 31.8427, -1},
-    	{"CuW_l23_pre3", cuMat, 3568.115, 3569.515, 162.2639, 31.8427, -1},
-    	{"CoolingplateCu_l23_pre4", cuMat, 3569.515, 3575.565, 162.2639, 31.8427, -1},
-    	{"CuW_l23_pre5", cuMat, 3575.565, 3576.965, 162.2639, 31.8427, -1},
-    	//{"glue_l23_pre6", glueMat, 3576.965, 3577.03, 162.2639, 31.8427, -1},
-    	{"kapton_l23_pre7", kaptonMat, 3577.03, 3577.295, 162.2639, 31.8427, -1},
-    	//{"glue_l23_pre8", glueMat, 3577.295, 3577.36, 162.2639, 31.8427, -1},
-
-    	//{"glue_l24_post1", glueMat, 3577.66, 3577.735, 160.7422, 31.8427, -1},
-    	{"PCBHexaboard_l24_pre1", pcbMat, 3577.735, 3579.335, 160.7422, 31.8427, -1},
-    	//{"Airelectronics_l24_pre2", airMat, 3579.335, 3583.065, 160.7422, 31.8427, -1},
-    	{"PCB_l24_pre3", pcbMat, 3583.065, 3584.665, 160.7422, 31.8427, -1},
-    	//{"Air_l24_pre4", airMat, 3584.665, 3584.89, 160.7422, 31.8427, -1},
-    	{"Cu_l24_pre5", cuMat, 3584.89, 3584.99, 160.7422, 31.8427, -1},
-    	{"StainlessSteel_l24_pre6", stainlessMat, 3584.99, 3585.29, 160.7422, 31.8427, -1},
-    	//{"glue_l24_pre7", glueMat, 3585.29, 3585.34, 160.7422, 31.8427, -1},
-    	{"Lead_l24_pre8", pbMat, 3585.34, 3593.56, 160.7422, 31.8427, -1},
-    	//{"glue_l24_pre9", glueMat, 3593.56, 3593.61, 160.7422, 31.8427, -1},
-    	{"StainlessSteel_l24_pre10", stainlessMat, 3593.61, 3593.91, 160.7422, 31.8427, -1},
-    	{"Cu_l24_pre11", cuMat, 3593.91, 3594.01, 160.7422, 31.8427, -1},
-    	//{"Air_l24_pre12", airMat, 3594.01, 3594.235, 160.7422, 31.8427, -1},
-    	{"PCB_l24_pre13", pcbMat, 3594.235, 3595.835, 160.7422, 31.8427, -1},
-    	//{"Airelectronics_l24_pre14", airMat, 3595.835, 3599.565, 160.7422, 31.8427, -1},
-    	{"PCBHexaboard_l24_pre15", pcbMat, 3599.565, 3601.165, 160.7422, 31.8427, -1},
-    	//{"glue_l24_pre16", glueMat, 3601.165, 3601.24, 160.7422, 31.8427, -1},
-
-    	//{"glue_l25_post1", glueMat, 3601.54, 3601.605, 162.9424, 31.8427, -1},
-    	{"kapton_l25_pre1", kaptonMat, 3601.605, 3601.87, 162.9424, 31.8427, -1},
-    	//{"glue_l25_pre2", glueMat, 3601.87, 3601.935, 162.9424, 31.8427, -1},
-    	{"CuW_l25_pre3", cuMat, 3601.935, 3603.335, 162.9424, 31.8427, -1},
-    	{"CoolingplateCu_l25_pre4", cuMat, 3603.335, 3609.385, 162.9424, 31.8427, -1},
-    	{"CuW_l25_pre5", cuMat, 3609.385, 3610.785, 162.9424, 31.8427, -1},
-    	//{"glue_l25_pre6", glueMat, 3610.785, 3610.85, 162.9424, 31.8427, -1},
-    	{"kapton_l25_pre7", kaptonMat, 3610.85, 3611.115, 162.9424, 31.8427, -1},
-    	//{"glue_l25_pre8", glueMat, 3611.115, 3611.18, 162.9424, 31.8427, -1},
-
-    	//{"glue_l26_post1", glueMat, 3611.48, 3611.555, 160.7422, 31.8427, -1},
-    	{"PCBHexaboard_l26_pre1", pcbMat, 3611.555, 3613.155, 160.7422, 31.8427, -1},
-    	//{"Airelectronics_l26_pre2", airMat, 3613.155, 3616.885, 160.7422, 31.8427, -1},
-    	{"PCB_l26_pre3", pcbMat, 3616.885, 3618.485, 160.7422, 31.8427, -1},
-    	//{"Air_l26_pre4", airMat, 3618.485, 3618.71, 160.7422, 31.8427, -1},
-    	{"StainlessSteel_l26_pre5", stainlessMat, 3618.71, 3619.71, 160.7422, 31.8427, -1},
-    	{"StainlessSteel_l26_pre6", stainlessMat, 3619.71, 3664.71, 160.7422, 31.8427, -1},
-    	//{"Air_l26_pre7", airMat, 3664.71, 3668.71, 160.7422, 31.8427, -1},
-    	{"StainlessSteel_l26_pre8", stainlessMat, 3668.71, 3671.21, 160.7422, 31.8427, -1},
-    	//{"Air_l26_pre9", airMat, 3671.21, 3671.61, 160.7422, 31.8427, -1},
-    	{"PCB_l26_pre10", pcbMat, 3671.61, 3673.21, 160.7422, 31.8427, -1},
-    	//{"Airelectronics_l26_pre11", airMat, 3673.21, 3676.685, 160.7422, 31.8427, -1},
-    	{"PCBHexaboard_l26_pre12", pcbMat, 3676.685, 3678.285, 160.7422, 31.8427, -1},
-    	//{"glue_l26_pre13", glueMat, 3678.285, 3678.36, 160.7422, 31.8427, -1},
-
-    	//{"glue_l27_post1", glueMat, 3678.66, 3678.735, 164.1638, 35.3184, -1},
-    	{"kapton_l27_pre1", kaptonMat, 3678.735, 3678.835, 164.1638, 35.3184, -1},
-    	//{"glue_l27_pre2", glueMat, 3678.835, 3678.91, 164.1638, 35.3184, -1},
-    	{"PCB_l27_pre3", pcbMat, 3678.91, 3679.91, 164.1638, 35.3184, -1},
-    	{"CoolingplateCu_l27_pre4", cuMat, 3679.91, 3686.26, 164.1638, 35.3184, -1},
-    	{"Absorberplate_l27_pre5", stainlessMat, 3686.26, 3727.76, 164.1638, 35.3184, -1},
-    	//{"Air_l27_pre6", airMat, 3727.76, 3731.76, 164.1638, 35.3184, -1},
-    	{"StainlessSteel_l27_pre7", stainlessMat, 3731.76, 3734.26, 164.1638, 35.3184, -1},
-    	//{"Air_l27_pre8", airMat, 3734.26, 3734.66, 164.1638, 35.3184, -1},
-    	{"PCB_l27_pre9", pcbMat, 3734.66, 3736.26, 164.1638, 35.3184, -1},
-    	//{"Airelectronics_l27_pre10", airMat, 3736.26, 3739.735, 164.1638, 35.3184, -1},
-    	{"PCBHexaboard_l27_pre11", pcbMat, 3739.735, 3741.335, 164.1638, 35.3184, -1},
-    	//{"glue_l27_pre12", glueMat, 3741.335, 3741.41, 164.1638, 35.3184, -1},
-
-    	//{"glue_l28_post1", glueMat, 3741.71, 3741.785, 167.686, 35.3184, -1},
-    	{"kapton_l28_pre1", kaptonMat, 3741.785, 3741.885, 167.686, 35.3184, -1},
-    	//{"glue_l28_pre2", glueMat, 3741.885, 3741.96, 167.686, 35.3184, -1},
-    	{"PCB_l28_pre3", pcbMat, 3741.96, 3742.96, 167.686, 35.3184, -1},
-    	{"CoolingplateCu_l28_pre4", cuMat, 3742.96, 3749.31, 167.686, 35.3184, -1},
-    	{"ABsorberplate_l28_pre5", stainlessMat, 3749.31, 3790.81, 167.686, 35.3184, -1},
-    	//{"Air_l28_pre6", airMat, 3790.81, 3794.81, 167.686, 35.3184, -1},
-    	{"StainlessSteel_l28_pre7", stainlessMat, 3794.81, 3797.31, 167.686, 35.3184, -1},
-    	//{"Air_l28_pre8", airMat, 3797.31, 3797.71, 167.686, 35.3184, -1},
-    	{"PCB_l28_pre9", pcbMat, 3797.71, 3799.31, 167.686, 35.3184, -1},
-    	//{"Airelectronics_l28_pre10", airMat, 3799.31, 3802.785, 167.686, 35.3184, -1},
-    	{"PCBHexaboard_l28_pre11", pcbMat, 3802.785, 3804.385, 167.686, 35.3184, -1},
-    	//{"glue_l28_pre12", glueMat, 3804.385, 3804.46, 167.686, 35.3184, -1},
-
-    	//{"glue_l29_post1", glueMat, 3804.76, 3804.835, 168.9036, 35.3184, -1},
-    	{"kapton_l29_pre1", kaptonMat, 3804.835, 3804.935, 168.9036, 35.3184, -1},
-    	//{"glue_l29_pre2", glueMat, 3804.935, 3805.01, 168.9036, 35.3184, -1},
-    	{"PCB_l29_pre3", pcbMat, 3805.01, 3806.01, 168.9036, 35.3184, -1},
-    	{"CoolingplateCu_l29_pre4", cuMat, 3806.01, 3812.36, 168.9036, 35.3184, -1},
-    	{"Absorberplate_l29_pre5", stainlessMat, 3812.36, 3853.86, 168.9036, 35.3184, -1},
-    	//{"Air_l29_pre6", airMat, 3853.86, 3857.86, 168.9036, 35.3184, -1},
-    	{"StainlessSteel_l29_pre7", stainlessMat, 3857.86, 3860.36, 168.9036, 35.3184, -1},
-    	//{"Air_l29_pre8", airMat, 3860.36, 3860.76, 168.9036, 35.3184, -1},
-    	{"PCB_l29_pre9", pcbMat, 3860.76, 3862.36, 168.9036, 35.3184, -1},
-    	//{"Airelectronics_l29_pre10", airMat, 3862.36, 3865.835, 168.9036, 35.3184, -1},
-    	{"PCBHexaboard_l29_pre11", pcbMat, 3865.835, 3867.435, 168.9036, 35.3184, -1},
-    	//{"glue_l29_pre12", glueMat, 3867.435, 3867.51, 168.9036, 35.3184, -1},
-
-    	//{"glue_l30_post1", glueMat, 3867.81, 3867.885, 171.7523, 35.3184, -1},
-    	{"kapton_l30_pre1", kaptonMat, 3867.885, 3867.985, 171.7523, 35.3184, -1},
-    	//{"glue_l30_pre2", glueMat, 3867.985, 3868.06, 171.7523, 35.3184, -1},
-    	{"PCB_l30_pre3", pcbMat, 3868.06, 3869.06, 171.7523, 35.3184, -1},
-    	{"CoolingplateCu_l30_pre4", cuMat, 3869.06, 3875.41, 171.7523, 35.3184, -1},
-    	{"Absorber_l30_pre5", stainlessMat, 3875.41, 3916.91, 171.7523, 35.3184, -1},
-    	//{"Air_l30_pre6", airMat, 3916.91, 3920.91, 171.7523, 35.3184, -1},
-    	{"StainlessSteel_l30_pre7", stainlessMat, 3920.91, 3923.41, 171.7523, 35.3184, -1},
-    	//{"Air_l30_pre8", airMat, 3923.41, 3923.81, 171.7523, 35.3184, -1},
-    	{"PCB_l30_pre9", pcbMat, 3923.81, 3925.41, 171.7523, 35.3184, -1},
-    	//{"Airelectronics_l30_pre10", airMat, 3925.41, 3928.885, 171.7523, 35.3184, -1},
-    	{"PCBHexaboard_l30_pre11", pcbMat, 3928.885, 3930.485, 171.7523, 35.3184, -1},
-    	//{"glue_l30_pre12", glueMat, 3930.485, 3930.56, 171.7523, 35.3184, -1},
-
-    	//{"glue_l31_post1", glueMat, 3930.86, 3930.935, 175.8206, 35.3184, -1},
-    	{"kapton_l31_pre1", kaptonMat, 3930.935, 3931.035, 175.8206, 35.3184, -1},
-    	//{"glue_l31_pre2", glueMat, 3931.035, 3931.11, 175.8206, 35.3184, -1},
-    	{"PCB_l31_pre3", pcbMat, 3931.11, 3932.11, 175.8206, 35.3184, -1},
-    	{"CoolingplateCu_l31_pre4", cuMat, 3932.11, 3938.46, 175.8206, 35.3184, -1},
-    	{"Absorberplate_l31_pre5", stainlessMat, 3938.46, 3979.96, 175.8206, 35.3184, -1},
-    	//{"Air_l31_pre6", airMat, 3979.96, 3983.96, 175.8206, 35.3184, -1},
-    	{"StainlessSteel_l31_pre7", stainlessMat, 3983.96, 3986.46, 175.8206, 35.3184, -1},
-    	//{"Air_l31_pre8", airMat, 3986.46, 3986.86, 175.8206, 35.3184, -1},
-    	{"PCB_l31_pre9", pcbMat, 3986.86, 3988.46, 175.8206, 35.3184, -1},
-    	//{"Airelectronics_l31_pre10", airMat, 3988.46, 3991.935, 175.8206, 35.3184, -1},
-    	{"PCBHexaboard_l31_pre11", pcbMat, 3991.935, 3993.535, 175.8206, 35.3184, -1},
-    	//{"glue_l31_pre12", glueMat, 3993.535, 3993.61, 175.8206, 35.3184, -1},
-
-    	//{"glue_l32_post1", glueMat, 3993.91, 3993.985, 183.6329, 35.3184, -1},
-    	{"kapton_l32_pre1", kaptonMat, 3993.985, 3994.085, 183.6329, 35.3184, -1},
-    	//{"glue_l32_pre2", glueMat, 3994.085, 3994.16, 183.6329, 35.3184, -1},
-    	{"PCB_l32_pre3", pcbMat, 3994.16, 3995.16, 183.6329, 35.3184, -1},
-    	{"CoolingplateCu_l32_pre4", cuMat, 3995.16, 4001.51, 183.6329, 35.3184, -1},
-    	{"Absorberplate_l32_pre5", stainlessMat, 4001.51, 4043.01, 183.6329, 35.3184, -1},
-    	//{"Air_l32_pre6", airMat, 4043.01, 4047.01, 183.6329, 35.3184, -1},
-    	{"StainlessSteel_l32_pre7", stainlessMat, 4047.01, 4049.51, 183.6329, 35.3184, -1},
-    	//{"Air_l32_pre8", airMat, 4049.51, 4049.91, 183.6329, 35.3184, -1},
-    	{"PCB_l32_pre9", pcbMat, 4049.91, 4051.51, 183.6329, 35.3184, -1},
-    	//{"Airelectronics_l32_pre10", airMat, 4051.51, 4054.985, 183.6329, 35.3184, -1},
-    	{"PCBHexaboard_l32_pre111", pcbMat, 4054.985, 4056.585, 183.6329, 35.3184, -1},
-    	//{"glue_l32_pre12", glueMat, 4056.585, 4056.66, 183.6329, 35.3184, -1},
-
-    	//{"glue_l33_post1", glueMat, 4056.96, 4057.035, 191.4564, 35.3184, -1},
-    	{"kapton_l33_pre1", kaptonMat, 4057.035, 4057.135, 191.4564, 35.3184, -1},
-    	//{"glue_l33_pre2", glueMat, 4057.135, 4057.21, 191.4564, 35.3184, -1},
-    	{"PCB_l33_pre3", pcbMat, 4057.21, 4058.21, 191.4564, 35.3184, -1},
-    	{"CoolingplateCu_l33_pre4", cuMat, 4058.21, 4064.56, 191.4564, 35.3184, -1},
-    	{"Absorberplate_l33_pre5", stainlessMat, 4064.56, 4106.06, 191.4564, 35.3184, -1},
-    	//{"Air_l33_pre6", airMat, 4106.06, 4110.06, 191.4564, 35.3184, -1},
-    	{"StainlessSteel_l33_pre7", stainlessMat, 4110.06, 4112.56, 191.4564, 35.3184, -1},
-    	//{"Air_l33_pre8", airMat, 4112.56, 4112.96, 191.4564, 35.3184, -1},
-    	{"PCB_l33_pre9", pcbMat, 4112.96, 4114.56, 191.4564, 35.3184, -1},
-    	//{"Airelectronics_l33_pre10", airMat, 4114.56, 4118.035, 191.4564, 35.3184, -1},
-    	{"PCBHexaboard_l33_pre11", pcbMat, 4118.035, 4119.635, 191.4564, 35.3184, -1},
-    	//{"glue_l33_pre12", glueMat, 4119.635, 4119.71, 191.4564, 35.3184, -1},
-
-    	//{"glue_l34_post1", glueMat, 4120.01, 4120.085, 197.5766, 42.5782, -1},
-    	{"kapton_l34_pre1", kaptonMat, 4120.085, 4120.185, 197.5766, 42.5782, -1},
-    	//{"glue_l34_pre2", glueMat, 4120.185, 4120.26, 197.5766, 42.5782, -1},
-    	{"PCB_l34_pre3", pcbMat, 4120.26, 4121.26, 197.5766, 42.5782, -1},
-    	{"CoolingplateCu_l34_pre4", cuMat, 4121.26, 4127.61, 197.5766, 42.5782, -1},
-    	{"Absorberplate_l34_pre5", stainlessMat, 4127.61, 4169.0, 197.5766, 42.5782, -1},
-    	//{"Air_l34_pre6", airMat, 4169.0, 35.3184.11, 4173.11, 197.5766, 42.5782, -1},
-    	{"StainlessSteel_l34_pre7", stainlessMat, 4173.11, 4175.61, 197.5766, 42.5782, -1},
-    	//{"Air_l34_pre8", airMat, 4175.61, 4176.01, 197.5766, 42.5782, -1},
-    	{"PCB_l34_pre9", pcbMat, 4176.01, 4177.61, 197.5766, 42.5782, -1},
-    	//{"Airelectronics_l34_pre10", airMat, 4177.61, 4181.085, 197.5766, 42.5782, -1},
-    	{"PCBHexaboard_l34_pre11", pcbMat, 4181.085, 4182.685, 197.5766, 42.5782, -1},
-    	//{"glue_l34_pre12", glueMat, 4182.685, 4182.76, 197.5766, 42.5782, -1},
-
-    	//{"glue_l35_post1", glueMat, 4183.06, 4183.135, 206.3885, 42.5782, -1},
-    	{"kapton_l35_pre1", kaptonMat, 4183.135, 4183.235, 206.3885, 42.5782, -1},
-    	//{"glue_l35_pre2", glueMat, 4183.235, 4183.31, 206.3885, 42.5782, -1},
-    	{"PCB_l35_pre3", pcbMat, 4183.31, 4184.31, 206.3885, 42.5782, -1},
-    	{"CoolingplateCu_l35_pre4", cuMat, 4184.31, 4190.66, 206.3885, 42.5782, -1},
-    	{"Absorberplate_l35_pre5", stainlessMat, 4190.66, 4232.16, 206.3885, 42.5782, -1},
-    	//{"Air_l35_pre6", airMat, 4232.16, 4236.16, 206.3885, 42.5782, -1},
-    	{"StainlessSteel_l35_pre7", stainlessMat, 4236.16, 4238.66, 206.3885, 42.5782, -1},
-    	//{"Air_l35_pre8", airMat, 4238.66, 4239.06, 206.3885, 42.5782, -1},
-    	{"PCB_l35_pre9", pcbMat, 4239.06, 4240.66, 206.3885, 42.5782, -1},
-    	//{"Airelectronics_l35_pre10", airMat, 4240.66, 4244.135, 206.3885, 42.5782, -1},
-    	{"PCBHexaboard_l35_pre11", pcbMat, 4244.135, 4245.735, 206.3885, 42.5782, -1},
-    	//{"glue_l35_pre12", glueMat, 4245.735, 4245.81, 206.3885, 42.5782, -1},
-
-    	//{"glue_l36_post1", glueMat, 4246.11, 4246.185, 215.594, 42.5782, -1},
-    	{"kapton_l36_pre1", kaptonMat, 4246.185, 4246.285, 215.594, 42.5782, -1},
-    	//{"glue_l36_pre2", glueMat, 4246.285, 4246.36, 215.594, 42.5782, -1},
-    	{"PCB_l36_pre3", pcbMat, 4246.36, 4247.36, 215.594, 42.5782, -1},
-    	{"CoolingplateCu_l36_pre4", cuMat, 4247.36, 4253.71, 215.594, 42.5782, -1},
-    	{"Absorberplate_l36_pre5", stainlessMat, 4253.71, 4295.21, 215.594, 42.5782, -1},
-    	//{"Air_l36_pre6", airMat, 4295.21, 4299.21, 215.594, 42.5782, -1},
-    	{"StainlessSteel_l36_pre7", stainlessMat, 4299.21, 4301.71, 215.594, 42.5782, -1},
-    	//{"Air_l36_pre8", airMat, 4301.71, 4302.11, 215.594, 42.5782, -1},
-    	{"PCB_l36_pre9", pcbMat, 4302.11, 4303.71, 215.594, 42.5782, -1},
-    	//{"Airelectronics_l36_pre10", airMat, 4303.71, 4307.185, 215.594, 42.5782, -1},
-    	{"PCBHexaboard_l36_pre11", pcbMat, 4307.185, 4308.785, 215.594, 42.5782, -1},
-    	//{"glue_l36_pre12", glueMat, 4308.785, 4308.86, 215.594, 42.5782, -1},
-
-    	//{"glue_l37_post1", glueMat, 4309.16, 4309.235, 215.594, 42.5782, -1},
-    	{"kapton_l37_pre1", kaptonMat, 4309.235, 4309.335, 215.594, 42.5782, -1},
-    	//{"glue_l37_pre2", glueMat, 4309.335, 4309.41, 215.594, 42.5782, -1},
-    	{"PCB_l37_pre3", pcbMat, 4309.41, 4310.41, 215.594, 42.5782, -1},
-    	{"CoolingplateCu_l37_pre4", cuMat, 4310.41, 4316.76, 215.594, 42.5782, -1},
-    	{"Absorberplate_l37_pre5", stainlessMat, 4316.76, 4377.46, 215.594, 42.5782, -1},
-    	//{"Air_l37_pre6", airMat, 4377.46, 4381.46, 215.594, 42.5782, -1},
-    	{"StainlessSteel_l37_pre7", stainlessMat, 4381.46, 4383.96, 215.594, 42.5782, -1},
-    	//{"Air_l37_pre8", airMat, 4383.96, 4384.36, 215.594, 42.5782, -1},
-    	{"PCB_l37_pre9", pcbMat, 4384.36, 4385.96, 215.594, 42.5782, -1},
-    	//{"Airelectronics_l37_pre10", airMat, 4385.96, 4389.435, 215.594, 42.5782, -1},
-    	{"PCBHexaboard_l37_pre11", pcbMat, 4389.435, 4391.035, 215.594, 42.5782, -1},
-    	//{"glue_l37_pre12", glueMat, 4391.035, 4391.11, 215.594, 42.5782, -1},
-
-    	//{"glue_l38_post1", glueMat, 4391.41, 4391.485, 235.255, 48.3669, -1},
-    	{"kapton_l38_pre1", kaptonMat, 4391.485, 4391.585, 235.255, 48.3669, -1},
-    	//{"glue_l38_pre2", glueMat, 4391.585, 4391.66, 235.255, 48.3669, -1},
-    	{"PCB_l38_pre3", pcbMat, 4391.66, 4392.66, 235.255, 48.3669, -1},
-    	{"CoolingplateCu_l38_pre4", cuMat, 4392.66, 4399.01, 235.255, 48.3669, -1},
-    	{"Absorberplate_l38_pre5", stainlessMat, 4399.01, 4459.71,235.255, 48.3669, -1},
-    	//{"Air_l38_pre6", airMat, 4459.71, 4463.71, 235.255, 48.3669, -1},
-    	{"StainlessSteel_l38_pre7", stainlessMat, 4463.71, 4466.21, 235.255, 48.3669, -1},
-    	//{"Air_l38_pre8", airMat, 4466.21, 4466.61, 235.255, 48.3669, -1},
-    	{"PCB_l38_pre9", pcbMat, 4466.61, 4468.21, 235.255, 48.3669, -1},
-    	//{"Airelectronics_l38_pre10", airMat, 4468.21, 4471.685, 235.255, 48.3669, -1},
-    	{"PCBHexaboard_l38_pre11", pcbMat, 4471.685, 4473.285, 235.255, 48.3669, -1},
-    	//{"glue_l38_pre12", glueMat, 4473.285, 4473.36, 235.255, 48.3669, -1},
-
-    	//{"glue_l39_post1", glueMat, 4473.66, 4473.735, 245.7481, 48.3669, -1},
-    	{"kapton_l39_pre1", kaptonMat, 4473.735, 4473.835, 245.7481, 48.3669, -1},
-    	//{"glue_l39_pre2", glueMat, 4473.835, 4473.91, 245.7481, 48.3669, -1},
-    	{"PCB_l39_pre3", pcbMat, 4473.835, 4474.91, 245.7481, 48.3669, -1},
-    	{"CoolingplateCu_l39_pre4", cuMat, 4474.91, 4481.26, 245.7481, 48.3669, -1},
-    	{"Absorberplate_l39_pre5", stainlessMat, 4481.26, 4541.96, 245.7481, 48.3669, -1},
-    	//{"Air_l39_pre6", airMat, 4541.96, 4545.96, 245.7481, 48.3669, -1},
-    	{"StainlessSteel_l39_pre7", stainlessMat, 4545.96, 4548.46, 245.7481, 48.3669, -1},
-    	//{"Air_l39_pre8", airMat, 4548.46, 4548.86, 245.7481, 48.3669, -1},
-    	{"PCB_l39_pre9", pcbMat, 4548.86, 4550.46, 245.7481, 48.3669, -1},
-    	//{"Airelectronics_l39_pre10", airMat, 4550.46, 4553.935, 245.7481, 48.3669, -1},
-    	{"PCBHexaboard_l39_pre11", pcbMat, 4553.935, 4555.535, 245.7481, 48.3669, -1},
-    	//{"glue_l39_pre12", glueMat, 4555.535, 4555.61, 245.7481, 48.3669, -1},
-
-    	//{"glue_l40_post1", glueMat, 4555.91, 4555.985, 256.7096, 48.3669, -1},
-    	{"kapton_l40_pre1", kaptonMat, 4555.985, 4556.085, 256.7096, 48.3669, -1},
-    	//{"glue_l40_pre2", glueMat, 4556.085, 4556.16, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l40_pre3", pcbMat, 4556.16, 4557.16, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l40_pre4", cuMat, 4557.16, 4563.51, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l40_pre5", stainlessMat, 4563.51, 4624.21, 256.7096, 48.3669, -1},
-    	//{"Air_l40_pre6", airMat, 4624.21, 4628.21, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l40_pre7", stainlessMat, 4628.21, 4630.71, 256.7096, 48.3669, -1},
-    	//{"Air_l40_pre8", airMat, 4630.71, 4631.11, 256.7096, 48.3669, -1},
-    	{"PCB_l40_pre9", pcbMat, 4631.11, 4632.71, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l40_pre10", airMat, 4632.71, 4636.185, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l40_pre11", pcbMat, 4636.185, 4637.785, 256.7096, 48.3669, -1},
-    	//{"glue_l40_pre12", glueMat, 4637.785, 4637.86, 256.7096, 48.3669, -1},
-
-    	//{"glue_l41_post1", glueMat, 4638.16, 4638.235, 256.7096, 48.3669, -1},
-    	{"kapton_l41_pre1", kaptonMat, 4638.235, 4638.335, 256.7096, 48.3669, -1},
-    	//{"glue_l41_pre2", glueMat, 4638.335, 4638.41, 256.7096, 48.3669, -1},
-    	{"PCB_l41_pre3", pcbMat, 4638.41, 4639.61, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l41_pre4", cuMat, 4639.61, 4645.76, 256.7096, 48.3669, -1},
-    	{"ABsorberplate_l41_pre5", stainlessMat, 4645.76, 4706.46, 256.7096, 48.3669, -1},
-    	//{"Air_l41_pre6", airMat, 4706.46, 4710.46, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l41_pre7", stainlessMat, 4710.46, 4712.96, 256.7096, 48.3669, -1},
-    	//{"Air_l41_pre8", airMat, 4712.96, 4713.36, 256.7096, 48.3669, -1},
-    	{"PCB_l41_pre9", pcbMat, 4713.36, 4714.96, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l41_pre10", airMat, 4714.96, 4718.435, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l41_pre11", pcbMat, 4718.435, 4720.035, 256.7096, 48.3669, -1},
-    	//{"glue_l41_pre12", glueMat, 4720.035, 4720.11, 256.7096, 48.3669, -1},
-
-    	//{"glue_l42_post1", glueMat, 4720.41, 4720.485, 256.7096, 48.3669, -1},
-    	{"kapton_l42_pre1", kaptonMat, 4720.485, 4720.585, 256.7096, 48.3669, -1},
-    	//{"glue_l42_pre2", glueMat, 4720.585, 4720.66, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l42_pre3", pcbMat, 4720.66, 4721.66, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l42_pre4", cuMat, 4721.66, 4728.01, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l42_pre5", stainlessMat, 4728.01, 4788.71, 256.7096, 48.3669, -1},
-    	//{"Air_l42_pre6", airMat, 4788.71, 4792.71, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l42_pre7", stainlessMat, 4792.71, 4795.21, 256.7096, 48.3669, -1},
-    	//{"Air_l42_pre8", airMat, 4795.21, 4795.61, 256.7096, 48.3669, -1},
-    	{"PCB_l42_pre9", pcbMat, 4795.61, 4797.21, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l42_pre10", airMat, 4797.21, 4800.685, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l42_pre11", pcbMat, 4800.685, 4802.285, 256.7096, 48.3669, -1},
-    	//{"glue_l42_pre12", glueMat, 4802.285, 4802.36, 256.7096, 48.3669, -1},
-
-    	//{"glue_l43_post1", glueMat, 4802.66, 4802.735, 256.7096, 48.3669, -1},
-    	{"kapton_l43_pre1", kaptonMat, 4802.735, 4802.835, 256.7096, 48.3669, -1},
-    	//{"glue_l43_pre2", glueMat, 4802.835, 4802.91, 256.7096, 48.3669, -1},
-    	{"PCB_l43_pre3", pcbMat, 4802.91, 4803.91, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l43_pre4", cuMat, 4803.91, 4810.26, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l43_pre5", stainlessMat, 4810.26, 4870.96, 256.7096, 48.3669, -1},
-    	//{"Air_l43_pre6", airMat, 4870.96, 4874.96, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l43_pre7", stainlessMat, 4874.96, 4877.46, 256.7096, 48.3669, -1},
-    	//{"Air_l43_pre8", airMat, 4877.46, 4877.86, 256.7096, 48.3669, -1},
-    	{"PCB_l43_pre9", pcbMat, 4877.86, 4879.46, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l43_pre10", airMat, 4879.46, 4882.935, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l43_pre11", pcbMat, 4882.935, 4884.535, 256.7096, 48.3669, -1},
-    	//{"glue_l43_pre12", glueMat, 4884.535, 4884.61, 256.7096, 48.3669, -1},
-
-    	//{"glue_l44_post1", glueMat, 4884.91, 4884.985, 256.7096, 48.3669, -1},
-    	{"kapton_l44_pre1", kaptonMat, 4884.985, 4885.085, 256.7096, 48.3669, -1},
-    	//{"glue_l44_pre2", glueMat, 4885.085, 4885.16, 256.7096, 48.3669, -1},
-    	{"PCB_l44_pre3", pcbMat, 4885.16, 4886.16, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l44_pre4", cuMat, 4886.16, 4892.51, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l44_pre5", stainlessMat, 4892.51, 4953.21, 256.7096, 48.3669, -1},
-    	//{"Air_l44_pre6", airMat, 4953.21, 4957.21, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l44_pre7", stainlessMat, 4957.21, 4959.71, 256.7096, 48.3669, -1},
-    	//{"Air_l44_pre8", airMat, 4959.71, 4960.11, 256.7096, 48.3669, -1},
-    	{"PCB_l44_pre9", pcbMat, 4960.11, 4961.71, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l44_pre10", airMat, 4961.71, 4965.185, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l44_pre11", pcbMat, 4965.185, 4966.785, 256.7096, 48.3669, -1},
-    	//{"glue_l44_pre12", glueMat, 4966.785, 4966.86, 256.7096, 48.3669, -1},
-
-    	//{"glue_l45_post1", glueMat, 4967.16, 4967.235, 256.7096, 48.3669, -1},
-    	{"kapton_l45_pre1", kaptonMat, 4967.235, 4967.335, 256.7096, 48.3669, -1},
-    	//{"glue_l45_pre2", glueMat, 4967.335, 4967.41, 256.7096, 48.3669, -1},
-    	{"PCB_l45_pre3", pcbMat, 4967.41, 4968.41, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l45_pre4", cuMat, 4968.41, 4974.76, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l45_pre5", stainlessMat, 4974.76, 5035.46, 256.7096, 48.3669, -1},
-    	//{"Air_l45_pre6", airMat, 5035.46, 5039.46, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l45_pre7", stainlessMat, 5039.46, 5041.96, 256.7096, 48.3669, -1},
-    	//{"Air_l45_pre8", airMat, 5041.96, 5042.36, 256.7096, 48.3669, -1},
-    	{"PCB_l45_pre9", pcbMat, 5042.36, 5043.96, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l45_pre10", airMat, 5043.96, 5047.435, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l45_pre11", pcbMat, 5047.435, 5049.035, 256.7096, 48.3669, -1},
-    	//{"glue_l45_pre12", glueMat, 5049.035, 5049.11, 256.7096, 48.3669, -1},
-
-    	//{"glue_l46_post1", glueMat, 5049.41, 5049.485, 256.7096, 48.3669, -1},
-    	{"kapton_l46_pre1", kaptonMat, 5049.485, 5049.585, 256.7096, 48.3669, -1},
-    	//{"glue_l46_pre2", glueMat, 5049.585, 5049.66, 256.7096, 48.3669, -1},
-    	{"PCB_l46_pre3", pcbMat, 5049.66, 5050.66, 256.7096, 48.3669, -1},
-    	{"CoolingplateCu_l46_pre4", cuMat, 5050.66, 5057.01, 256.7096, 48.3669, -1},
-    	{"Absorberplate_l46_pre5", stainlessMat, 5057.01, 5117.71, 256.7096, 48.3669, -1},
-    	//{"Air_l46_pre6", airMat, 5117.71, 5121.71, 256.7096, 48.3669, -1},
-    	{"StainlessSteel_l46_pre7", stainlessMat, 5121.71, 5124.21, 256.7096, 48.3669, -1},
-    	//{"Air_l46_pre8", airMat, 5124.21, 5124.61, 256.7096, 48.3669, -1},
-    	{"PCB_l46_pre9", pcbMat, 5124.61, 5126.21, 256.7096, 48.3669, -1},
-    	//{"Airelectronics_l46_pre10", airMat, 5126.21, 5129.685, 256.7096, 48.3669, -1},
-    	{"PCBHexaboard_l46_pre11", pcbMat, 5129.685, 5131.285, 256.7096, 48.3669, -1},
-    	//{"glue_l46_pre12", glueMat, 5131.285, 5131.36, 256.7096, 48.3669, -1},
-
-    	//{"glue_l47_post1", glueMat, 5131.66, 5131.735, 245.7481, 48.3669, -1},
-    	{"kapton_l47_pre1", kaptonMat, 5131.735, 5131.835, 245.7481, 48.3669, -1},
-    	//{"glue_l47_pre2", glueMat, 5131.835, 5131.91, 245.7481, 48.3669, -1},
-    	{"PCB_l47_pre3", pcbMat, 5131.91, 5132.91, 245.7481, 48.3669, -1},
-    	{"CoolingplateCu_l47_pre4", cuMat, 5132.91, 5139.26, 245.7481, 48.3669, -1},
-    	
-    };
+    std::vector<LayerMother> mothers = BuildMothers(logicWorld, siliconLayers, nonSiliconLayers);
 
     // ---------------------
     // Create silicon layers
     // ---------------------
     int siLayerCounter = 0;
+    fSiliconLogicals.clear();
+    fSiliconPlanes.clear();
     for (const auto& layer : siliconLayers) {
         G4double thickness = (layer.zMax - layer.zMin) * mm;
         G4double zPos = (layer.zMin + layer.zMax) / 2.0 * mm;
@@ -807,17 +257,22 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
         G4String logicName = "logic_" + layer.name;
         G4LogicalVolume* logicLayer = new G4LogicalVolume(solidLayer, layer.material, logicName);
 
+        fSiliconLogicals.push_back(logicLayer);
+        fSiliconPlanes.push_back({layer.layerNumber, layer.zMin * mm, layer.zMax * mm, innerR, outerR});
+        siliconRegion->AddRootLogicalVolume(logicLayer);
+
         G4VisAttributes* siVis = new G4VisAttributes(G4Colour(0.0, 1.0, 1.0, 0.5));
         siVis->SetForceSolid(true);
         logicLayer->SetVisAttributes(siVis);
 
+        const LayerMother& mother = FindMother(mothers, zPos);
         G4String physName = "phys_" + layer.name;
         new G4PVPlacement(
             0,
-            G4ThreeVector(0, 0, zPos),
+            G4ThreeVector(0, 0, zPos - mother.zCentre),
             logicLayer,
             physName,
-            logicWorld,
+            mother.logical,
             false,
             layer.layerNumber,
             true
@@ -862,15 +317,24 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
 
         vis->SetForceSolid(false);
         logicLayer->SetVisAttributes(vis);
+
+        // PCB, kapton, glue and air vs. dense absorbers (Pb, Cu, steel and
+        // the mixtures of the merged stack)
+        if (layer.material == pcbMat || layer.material == kaptonMat || layer.material == glueMat ||
+            layer.material == airMat)
+            servicesRegion->AddRootLogicalVolume(logicLayer);
+        else
+            absorberRegion->AddRootLogicalVolume(logicLayer);
         
 
+        const LayerMother& mother = FindMother(mothers, zPos);
         G4String physName = "phys_" + layer.name;
         new G4PVPlacement(
             0,
-            G4ThreeVector(0, 0, zPos),
+            G4ThreeVector(0, 0, zPos - mother.zCentre),
             logicLayer,
             physName,
-            logicWorld,
+            mother.logical,
             false,
             2000 + nonSiLayerCounter,
             true
@@ -879,27 +343,206 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
         nonSiLayerCounter++;
     }
 
-    // ---------------------
-    // Register sensitive detector
-    // ---------------------
-    MySensitiveDetector* sensDet = new MySensitiveDetector("SensitiveDetector");
-    G4SDManager::GetSDMpointer()->AddNewDetector(sensDet);
+    constructionTimer.Stop();
+    static const char* const kNestingNames[] = {"flat", "envelope", "cassette"};
+    G4cout << "Geometry: " << kNestingNames[static_cast<int>(fNesting)] << " layout, "
+           << siLayerCounter + nonSiLayerCounter << " layers in " << mothers.size() << " mother volume(s), built in "
+           << constructionTimer.GetRealElapsed() << " s" << G4endl;
 
-    // Attach sensitive detector to silicon layers
+    fConstructed = true;
+    return physWorld;
+}
+
+std::vector<LayerMother> MyDetectorConstruction::BuildMothers(G4LogicalVolume* logicWorld,
+                                                              const std::vector<MaterialLayer>& siliconLayers,
+                                                              const std::vector<MaterialLayer>& nonSiliconLayers) {
+    std::vector<LayerMother> mothers;
+    if (fNesting == GeometryNesting::Flat) {
+        mothers.push_back({-DBL_MAX, DBL_MAX, 0., logicWorld});
+        return mothers;
+    }
+
+    // z ranges: the whole stack, or one range per cassette. A cassette ends at
+    // the back of its last sensor and holds everything upstream of it down to
+    // the previous cassette; material behind the last sensor joins the last one.
+    G4double zFront = DBL_MAX;
+    G4double zBack = -DBL_MAX;
+    for (const std::vector<MaterialLayer>* layers : {&siliconLayers, &nonSiliconLayers}) {
+        for (const auto& layer : *layers) {
+            zFront = std::min(zFront, layer.zMin * mm);
+            zBack = std::max(zBack, layer.zMax * mm);
+        }
+    }
+    std::vector<G4double> zEdges = {zFront};
+    if (fNesting == GeometryNesting::Cassette) {
+        std::vector<const MaterialLayer*> sensors;
+        for (const auto& layer : siliconLayers) sensors.push_back(&layer);
+        std::sort(sensors.begin(), sensors.end(),
+                  [](const MaterialLayer* a, const MaterialLayer* b) { return a->zMin < b->zMin; });
+        for (std::size_t i = 0; i + 1 < sensors.size(); ++i) {
+            // CE-E cassettes hold two sensors, CE-H cassettes one
+            G4bool pairedWithNext = sensors[i]->layerNumber <= kLastCEELayer && sensors[i]->layerNumber % 2 == 1;
+            if (!pairedWithNext) zEdges.push_back(sensors[i]->zMax * mm);
+        }
+    }
+    zEdges.push_back(zBack);
+
+    // Radial extent of each range from the layers it holds
+    std::size_t nRanges = zEdges.size() - 1;
+    std::vector<G4double> innerR(nRanges, DBL_MAX);
+    std::vector<G4double> outerR(nRanges, 0.);
+    for (const std::vector<MaterialLayer>* layers : {&siliconLayers, &nonSiliconLayers}) {
+        for (const auto& layer : *layers) {
+            G4double zCentre = (layer.zMin + layer.zMax) / 2.0 * mm;
+            std::size_t range = 0;
+            while (range + 1 < nRanges && zCentre >= zEdges[range + 1]) ++range;
+            innerR[range] = std::min(innerR[range], layer.innerRadius * cm);
+            outerR[range] = std::max(outerR[range], layer.outerRadius * cm);
+        }
+    }
+
+    // Endcap envelope (vacuum, like the gaps it replaces)
+    G4double envelopeInner = *std::min_element(innerR.begin(), innerR.end());
+    G4double envelopeOuter = *std::max_element(outerR.begin(), outerR.end());
+    G4double envelopeCentre = (zFront + zBack) / 2.0;
+    G4Tubs* solidEnvelope = new G4Tubs("solid_EndcapEnvelope", envelopeInner, envelopeOuter,
+                                       (zBack - zFront) / 2.0, 0.0, 2.0 * CLHEP::pi);
+    G4LogicalVolume* logicEnvelope = new G4LogicalVolume(solidEnvelope, fMaterials.Get("G4_Galactic"), "logic_EndcapEnvelope");
+    logicEnvelope->SetVisAttributes(G4VisAttributes::GetInvisible());
+    new G4PVPlacement(0, G4ThreeVector(0, 0, envelopeCentre), logicEnvelope, "phys_EndcapEnvelope",
+                      logicWorld, false, 0, true);
+
+    if (fNesting == GeometryNesting::Envelope) {
+        mothers.push_back({zFront, zBack, envelopeCentre, logicEnvelope});
+        return mothers;
+    }
+
+    for (std::size_t range = 0; range < nRanges; ++range) {
+        if (outerR[range] <= 0.) continue;  // no layer in this range
+        G4double zBegin = zEdges[range];
+        G4double zEnd = zEdges[range + 1];
+        G4double zCentre = (zBegin + zEnd) / 2.0;
+        G4String name = "Cassette_" + std::to_string(range + 1);
+        G4Tubs* solidCassette = new G4Tubs("solid_" + name, innerR[range], outerR[range],
+                                           (zEnd - zBegin) / 2.0, 0.0, 2.0 * CLHEP::pi);
+        G4LogicalVolume* logicCassette = new G4LogicalVolume(solidCassette, fMaterials.Get("G4_Galactic"), "logic_" + name);
+        logicCassette->SetVisAttributes(G4VisAttributes::GetInvisible());
+        new G4PVPlacement(0, G4ThreeVector(0, 0, zCentre - envelopeCentre), logicCassette, "phys_" + name,
+                          logicEnvelope, false, 3000 + static_cast<G4int>(range), true);
+        mothers.push_back({zBegin, zEnd, zCentre, logicCassette});
+    }
+    return mothers;
+}
+
+void MyDetectorConstruction::ComputeCEESummary(const std::vector<MaterialLayer>& siliconLayers,
+                                               const std::vector<MaterialLayer>& nonSiliconLayers) {
+    // Envelope: front face to the back of the last CE-E sensor
+    fCEEBackZ = fFrontFaceZ;
+    fCEEInnerRadius = DBL_MAX;
+    fCEEOuterRadius = 0.;
+    G4int nActive = 0;
+    G4double activeLength = 0.;
+    G4double activeElectrons = 0.;
     for (const auto& layer : siliconLayers) {
-        G4String logicName = "logic_" + layer.name;
-        G4LogicalVolume* layerLogic = G4LogicalVolumeStore::GetInstance()->GetVolume(logicName);
-        if (layerLogic)
-            layerLogic->SetSensitiveDetector(sensDet);
+        if (layer.layerNumber > kLastCEELayer) continue;
+        G4double thickness = (layer.zMax - layer.zMin) * mm;
+        fCEEBackZ = std::max(fCEEBackZ, layer.zMax * mm);
+        fCEEInnerRadius = std::min(fCEEInnerRadius, layer.innerRadius * cm);
+        fCEEOuterRadius = std::max(fCEEOuterRadius, layer.outerRadius * cm);
+        activeLength += thickness;
+        activeElectrons += thickness * layer.material->GetElectronDensity();
+        nActive++;
     }
+    if (nActive == 0) return;
 
-    return physWorld;
+    // Passive layers in front of that face, summed per material (areal density)
+    std::vector<std::pair<G4Material*, G4double>> passiveMass;
+    G4double totalMass = 0.;
+    G4double passiveElectrons = 0.;
+    for (const auto& layer : nonSiliconLayers) {
+        if (layer.zMax * mm > fCEEBackZ) continue;
+        G4double thickness = (layer.zMax - layer.zMin) * mm;
+        G4double mass = thickness * layer.material->GetDensity();
+        auto it = std::find_if(passiveMass.begin(), passiveMass.end(),
+                               [&layer](const std::pair<G4Material*, G4double>& entry) {
+                                   return entry.first == layer.material;
+                               });
+        if (it == passiveMass.end()) {
+            passiveMass.emplace_back(layer.material, mass);
+        } else {
+            it->second += mass;
+        }
+        totalMass += mass;
+        passiveElectrons += thickness * layer.material->GetElectronDensity();
+    }
+
+    // One sampling cell per sensor; gaps between layers count as passive length
+    G4double passiveLength = (fCEEBackZ - fFrontFaceZ) - activeLength;
+    fCEEPassiveThickness = passiveLength / nActive;
+    fCEEActiveThickness = activeLength / nActive;
+
+    // One mixture per stack variant (fidelity, glue and air change the composition)
+    G4String passiveName = "CEE_Passive";
+    if (fFidelity == GeometryFidelity::Merged) passiveName += "_merged";
+    if (fFidelity == GeometryFidelity::Toy) passiveName += "_toy";
+    if (fWithGlue) passiveName += "_glue";
+    if (fWithAir) passiveName += "_air";
+    fCEEPassive = G4Material::GetMaterial(passiveName, false);
+    if (!fCEEPassive) {
+        fCEEPassive = new G4Material(passiveName, totalMass / passiveLength,
+                                     static_cast<G4int>(passiveMass.size()));
+        for (const auto& entry : passiveMass) {
+            fCEEPassive->AddMaterial(entry.first, entry.second / totalMass);
+        }
+    }
+
+    // Parameterised showers deposit by geometry: a spot lands in silicon with
+    // probability activeLength / totalLength. Scale it to the mip-like visible
+    // fraction (energy loss ~ electron density); tune with /hgcal/sd/gflashWeight
+    G4double visibleFraction = activeElectrons / (activeElectrons + passiveElectrons);
+    G4double geometricFraction = activeLength / (fCEEBackZ - fFrontFaceZ);
+    fCEESiliconWeight = visibleFraction / geometricFraction;
+
+    G4cout << "CE-E summary: " << nActive << " sampling cells of "
+           << fCEEPassiveThickness / mm << " mm " << fCEEPassive->GetName()
+           << " (" << fCEEPassive->GetDensity() / (g/cm3) << " g/cm3) + "
+           << fCEEActiveThickness / mm << " mm Si, silicon weight "
+           << fCEESiliconWeight << G4endl;
 }
 
 void MyDetectorConstruction::ConstructSDandField() {
-    // Create uniform magnetic field along z-axis: 8.3 Tesla
-    G4ThreeVector fieldValue(0., 0., 3.8*tesla);
+    // ---------------------
+    // Register sensitive detector (one instance per thread)
+    // ---------------------
+    // (kept when the geometry is rebuilt; only the volumes are new)
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    MySensitiveDetector* sensDet = static_cast<MySensitiveDetector*>(
+        sdManager->FindSensitiveDetector("SensitiveDetector", false));
+    if (!sensDet) {
+        sensDet = new MySensitiveDetector("SensitiveDetector");
+        sdManager->AddNewDetector(sensDet);
+    }
+    sensDet->SetGFlashWeight(fCEESiliconWeight);
+
+    // Attach sensitive detector to silicon layers
+    for (G4LogicalVolume* layerLogic : fSiliconLogicals) {
+        SetSensitiveDetector(layerLogic, sensDet);
+    }
+
+    // Shower library for low-energy gamma/e+- started in the absorbers
+    // (inactive unless /hgcal/showerLibrary/mode use)
+    // (the region and its model outlive a geometry rebuild)
+    static G4ThreadLocal G4bool showerLibraryModelBuilt = false;
+    if (!showerLibraryModelBuilt) {
+        G4Region* absorberRegion = G4RegionStore::GetInstance()->GetRegion("EMAbsorbers");
+        G4AutoDelete::Register(new MyShowerLibraryModel("ShowerLibraryModel", absorberRegion));
+        showerLibraryModelBuilt = true;
+    }
+
+    // Create uniform magnetic field along z-axis: 3.8 Tesla
+    G4ThreeVector fieldValue(0., 0., fFieldZ);
     G4MagneticField* magneticField = new G4UniformMagField(fieldValue);
+    G4AutoDelete::Register(magneticField);
     
     // Get the global field manager
     G4FieldManager* fieldManager = 
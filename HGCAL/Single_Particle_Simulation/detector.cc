@@ -6,24 +6,76 @@
 #include "G4ThreeVector.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ios.hh"
+#include <algorithm>
 #include <cmath>
-#include "G4RunManager.hh"
-#include "G4AnalysisManager.hh"
-#include "G4Event.hh"
+#include "G4VTouchable.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4GFlashSpot.hh"
+#include "GFlashEnergySpot.hh"
+#include "G4FastTrack.hh"
+#include "ShowerLibrary.hh"
+#include "BoundaryTruth.hh"
 
 MySensitiveDetector::MySensitiveDetector(const G4String& name)
-: G4VSensitiveDetector(name)
+: G4VSensitiveDetector(name), fOpenHits(4096), fCellData(4096), fCellTruthData(4096),
+  fTrackHits(nullptr), fCellHits(nullptr), fCellTruthHits(nullptr),
+  fTrackHitsID(-1), fCellHitsID(-1), fCellTruthHitsID(-1),
+  fWriteCellHits(true), fGranularity(HitGranularity::Crossing), fGFlashWeight(1.0),
+  fTimeWindow(0.)
 {
+    collectionName.insert("TrackHits");
+    collectionName.insert("CellHits");
+    collectionName.insert("CellTruth");
+
+    fMessenger = new G4GenericMessenger(this, "/hgcal/sd/", "Sensitive detector control");
+    fMessenger->DeclareMethod("granularity", &MySensitiveDetector::SetGranularity,
+                              "Row granularity: step, crossing (default) or cell")
+        .SetCandidates("step crossing cell");
+    fMessenger->DeclareMethod("cellHits", &MySensitiveDetector::SetCellHits,
+                              "Write the per-event hexagonal cell energies (CellHits ntuple)")
+        .SetDefaultValue("true");
+    fMessenger->DeclareProperty("gflashWeight", fGFlashWeight,
+                                "Scale of parameterised shower energy landing in silicon (tune against full simulation)");
+    fMessenger->DeclarePropertyWithUnit("timeWindow", "ns", fTimeWindow,
+                                        "Readout window in global time; keep it at or below /hgcal/cuts/timeCut (0 disables)");
 }
 
 MySensitiveDetector::~MySensitiveDetector()
 {
+    delete fMessenger;
+}
+
+void MySensitiveDetector::SetGranularity(const G4String& granularity)
+{
+    if (granularity == "step") {
+        fGranularity = HitGranularity::Step;
+    } else if (granularity == "cell") {
+        fGranularity = HitGranularity::Cell;
+    } else {
+        fGranularity = HitGranularity::Crossing;
+    }
 }
 
 void MySensitiveDetector::Initialize(G4HCofThisEvent* hce)
 {
     // Clear temporary data for new event
-    fParticleData.clear();
+    fOpenHits.Clear();
+    fCellData.Clear();
+    fCellTruthData.Clear();
+
+    // Collections are owned by G4HCofThisEvent and deleted with the event
+    fTrackHits = new MyHitsCollection(SensitiveDetectorName, collectionName[0]);
+    fCellHits = new MyCellHitsCollection(SensitiveDetectorName, collectionName[1]);
+    fCellTruthHits = new MyCellTruthHitsCollection(SensitiveDetectorName, collectionName[2]);
+    if (fTrackHitsID < 0) {
+        fTrackHitsID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+        fCellHitsID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[1]);
+        fCellTruthHitsID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[2]);
+    }
+    hce->AddHitsCollection(fTrackHitsID, fTrackHits);
+    hce->AddHitsCollection(fCellHitsID, fCellHits);
+    hce->AddHitsCollection(fCellTruthHitsID, fCellTruthHits);
 }
 
 G4bool MySensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory* history)
@@ -38,6 +90,9 @@ G4bool MySensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory* histor
     const G4StepPoint* preStepPoint = step->GetPreStepPoint();
     const G4StepPoint* postStepPoint = step->GetPostStepPoint();
     if (!preStepPoint || !postStepPoint) return false;
+
+    // Outside the readout window
+    if (fTimeWindow > 0. && preStepPoint->GetGlobalTime() > fTimeWindow) return false;
     
     // Get basic track information
     G4int trackID = track->GetTrackID();
@@ -45,45 +100,41 @@ G4bool MySensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory* histor
     G4double charge = track->GetDefinition()->GetPDGCharge();  
     
     // Extract cumTr from track information
-    G4int cumTr = -1;  // Default value if not found
-    G4VUserTrackInformation* userInfo = track->GetUserInformation();
-    if (userInfo) {
-        TrackInformation* trackInfo = dynamic_cast<TrackInformation*>(userInfo);
-        if (trackInfo) {
-            cumTr = trackInfo->GetCumTr();
-        }
-    }
-    
-    // Get event ID safely
-    G4int eventID = 0;
-    const G4Event* currentEvent = G4RunManager::GetRunManager()->GetCurrentEvent();
-    if (currentEvent) {
-        eventID = currentEvent->GetEventID();
-    }
+    G4int cumTr = TrackInformation::CumTrOf(track);
     
     // Get layer information from copy number
     G4int copyNumber = preStepPoint->GetTouchable()->GetCopyNumber();
     G4int layer = copyNumber;
     
-    // Create unique identifier based on entry position and angle
-    G4ThreeVector entryPos = preStepPoint->GetPosition();
-    G4ThreeVector entryMom = preStepPoint->GetMomentum();
-
-    // Round to reasonable precision to create key
-    G4double entryX = entryPos.x();  // 0.1 mm precision
-    G4double entryY = entryPos.y();
-
-    std::string trackLayerKey = std::to_string(eventID) + "_" + 
-                                std::to_string(trackID) + "_" + 
-                                std::to_string(layer) + "_" +
-                                std::to_string(entryX) + "_" +
-                                std::to_string(entryY);
+    // Hexagonal cell of this step, looked up only when needed
+    G4double edep = step->GetTotalEnergyDeposit();
+    G4bool needCell = (fGranularity == HitGranularity::Cell) || (fWriteCellHits && edep > 0.);
+    HexCell hexCell{0, 0, 0, 0, false};
+    if (needCell) {
+        const G4ThreeVector& position = preStepPoint->GetPosition();
+        hexCell = HexCellGeometry::Locate(position.x(), position.y());
+    }
     
-    // Record entry data if this is the first step in this layer
-    if (fParticleData.find(trackLayerKey) == fParticleData.end()) {
+    // Sum the deposit into its cell
+    if (fWriteCellHits && edep > 0.) {
+        AddCellDeposit(HexCellGeometry::PackDetId(layer, hexCell), edep, preStepPoint->GetGlobalTime(),
+                       preStepPoint->GetTouchable()->GetTranslation().z(),
+                       TrackInformation::BoundaryIndexOf(track));
+    }
+
+    // Shower library generation: silicon deposits of recorded showers
+    if (ShowerLibrary::GetMode() == ShowerLibrary::kGenerate && edep > 0.) {
+        ShowerLibraryRecorder::Instance().AddDeposit(trackID, layer, preStepPoint->GetPosition(), edep);
+    }
     
-        ParticleData& data = fParticleData[trackLayerKey];
-        data.eventID = eventID;
+    // Packed integer key: no string formatting or allocation per step
+    std::uint32_t cell = (fGranularity == HitGranularity::Cell) ? HexCellIndex(hexCell) : 0;
+    std::uint64_t trackLayerKey = MakeHitKey(trackID, layer, cell);
+    
+    // Record entry data if this is the first step in this layer
+    G4bool inserted = false;
+    MyHit& data = fOpenHits.FindOrInsert(trackLayerKey, inserted);
+    if (inserted) {
         data.trackID = trackID;
         data.layer = layer;
         data.particleID = particleID;
@@ -98,74 +149,185 @@ G4bool MySensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory* histor
     }
     
     // Accumulate energy deposited in this step
-    auto it = fParticleData.find(trackLayerKey);
-    if (it != fParticleData.end()) {
-        ParticleData& data = it->second;
-        data.totalEnergyDeposited += step->GetTotalEnergyDeposit();
-        
-        // Update exit information (continuously updated until particle leaves)
-        data.energyAfter = postStepPoint->GetKineticEnergy();
-        data.momentumAfter = postStepPoint->GetMomentum();
-        data.positionExit = postStepPoint->GetPosition();
-        data.phiExit = data.momentumAfter.phi();
-        data.etaExit = data.momentumAfter.eta();
-        
-        // Check if particle is leaving the volume or stopping
-        if (data.totalEnergyDeposited > 10.0*eV) {
-            WriteParticleData(data);
-        }
-        fParticleData.erase(it);
-
+    data.totalEnergyDeposited += edep;
+    
+    // Update exit information (continuously updated until particle leaves)
+    data.energyAfter = postStepPoint->GetKineticEnergy();
+    data.momentumAfter = postStepPoint->GetMomentum();
+    data.positionExit = postStepPoint->GetPosition();
+    data.phiExit = data.momentumAfter.phi();
+    data.etaExit = data.momentumAfter.eta();
+    
+    // Decide whether this record is complete
+    G4bool closeRecord = false;
+    switch (fGranularity) {
+        case HitGranularity::Step:
+            closeRecord = true;
+            break;
+        case HitGranularity::Crossing:
+            // Particle is leaving the layer or stopping inside it
+            closeRecord = (postStepPoint->GetStepStatus() == fGeomBoundary) ||
+                          (track->GetTrackStatus() != fAlive);
+            break;
+        case HitGranularity::Cell:
+            // Cells are summed over the whole event and stored in EndOfEvent
+            break;
+    }
+    
+    if (closeRecord) {
+        StoreHit(data);
+        fOpenHits.Erase(trackLayerKey);
     }
     
     return true;
 }
 
+G4bool MySensitiveDetector::ProcessHits(G4GFlashSpot* spot, G4TouchableHistory* history)
+{
+    // Spots are placed by geometry alone; the weight turns the fraction that
+    // lands in silicon into the visible energy of a sampled shower
+    G4double edep = spot->GetEnergySpot()->GetEnergy() * fGFlashWeight;
+    if (edep <= 0.) return false;
+
+    const G4Track* track = spot->GetOriginatorTrack()->GetPrimaryTrack();
+    AddParameterisedDeposit(track, spot->GetTouchableHandle()->GetCopyNumber(), spot->GetPosition(),
+                            edep, track->GetGlobalTime(), spot->GetTouchableHandle()->GetTranslation().z());
+    return true;
+}
+
+void MySensitiveDetector::AddParameterisedDeposit(const G4Track* track, G4int layer, const G4ThreeVector& position,
+                                                  G4double edep, G4double time, G4double z)
+{
+    if (fTimeWindow > 0. && time > fTimeWindow) return;
+
+    HexCell hexCell = HexCellGeometry::Locate(position.x(), position.y());
+    if (fWriteCellHits) {
+        AddCellDeposit(HexCellGeometry::PackDetId(layer, hexCell), edep, time, z,
+                       TrackInformation::BoundaryIndexOf(track));
+    }
+
+    // One record per shower and layer (or cell). The shower has no per-layer
+    // kinematics: entry/exit are the first/last deposit, momenta the originator's.
+    std::uint32_t cell = (fGranularity == HitGranularity::Cell) ? HexCellIndex(hexCell) : 0;
+    std::uint64_t trackLayerKey = MakeHitKey(track->GetTrackID(), layer, cell);
+
+    G4bool inserted = false;
+    MyHit& data = fOpenHits.FindOrInsert(trackLayerKey, inserted);
+    if (inserted) {
+        data.trackID = track->GetTrackID();
+        data.layer = layer;
+        data.particleID = track->GetDefinition()->GetPDGEncoding();
+        data.cumTr = TrackInformation::CumTrOf(track);
+        data.charge = track->GetDefinition()->GetPDGCharge();
+        data.energyBefore = track->GetKineticEnergy();
+        data.energyAfter = track->GetKineticEnergy();
+        data.momentumBefore = track->GetMomentum();
+        data.momentumAfter = track->GetMomentum();
+        data.positionEnter = position;
+        data.totalEnergyDeposited = 0.0;
+        data.phiEnter = data.momentumBefore.phi();
+        data.etaEnter = data.momentumBefore.eta();
+        data.phiExit = data.phiEnter;
+        data.etaExit = data.etaEnter;
+    }
+    data.totalEnergyDeposited += edep;
+    data.positionExit = position;
+
+    // Crossing and cell records are stored in EndOfEvent
+    if (fGranularity == HitGranularity::Step) {
+        StoreHit(data);
+        fOpenHits.Erase(trackLayerKey);
+    }
+}
+
 void MySensitiveDetector::EndOfEvent(G4HCofThisEvent* hce)
 {
-   
-    fParticleData.clear();
+    // Store records still open at the end of the event
+    // (cell mode, or tracks killed after their last step in the layer)
+    fOpenHits.ForEach([this](std::uint64_t, const MyHit& data) {
+        StoreHit(data);
+    });
+    fOpenHits.Clear();
+
+    if (fWriteCellHits) {
+        if (PremixLibrary::GetMode() == PremixLibrary::kProduce) {
+            StorePremixEvent();
+        } else if (PremixLibrary::GetMode() == PremixLibrary::kOverlay && PremixLibrary::Instance().IsOpen()) {
+            OverlayPileup();
+        }
+    }
+
+    // Truth shares first, while the cell totals are still there
+    fCellTruthData.ForEach([this](std::uint64_t, MyCellTruthHit& data) {
+        const MyCellHit* cell = fCellData.Find(data.detId);
+        data.fraction = (cell && cell->edep > 0.) ? data.edep / cell->edep : 0.;
+        fCellTruthHits->insert(new MyCellTruthHit(data));
+    });
+    fCellTruthData.Clear();
+
+    fCellData.ForEach([this](std::uint64_t, const MyCellHit& data) {
+        fCellHits->insert(new MyCellHit(data));
+    });
+    fCellData.Clear();
 }
 
-void MySensitiveDetector::WriteParticleData(const ParticleData& data)
+void MySensitiveDetector::AddCellDeposit(std::uint32_t detId, G4double edep, G4double time, G4double z,
+                                         G4int boundaryIndex)
 {
-    G4AnalysisManager* man = G4AnalysisManager::Instance();
-    
-    // Calculate radial distances in x-y plane
-    G4double rEnter = std::sqrt(data.positionEnter.x() * data.positionEnter.x() + 
-                                data.positionEnter.y() * data.positionEnter.y());
-    G4double rExit = std::sqrt(data.positionExit.x() * data.positionExit.x() + 
-                               data.positionExit.y() * data.positionExit.y());
-    
-    // Fill ntuple columns 
-    man->FillNtupleIColumn(1, 0, data.eventID);
-    man->FillNtupleIColumn(1, 1, data.trackID);
-    man->FillNtupleIColumn(1, 2, data.layer);
-    man->FillNtupleDColumn(1, 3, data.energyBefore / MeV);
-    man->FillNtupleDColumn(1, 4, data.energyAfter / MeV);
-    man->FillNtupleDColumn(1, 5, data.totalEnergyDeposited / MeV);
-    man->FillNtupleDColumn(1, 6, data.momentumBefore.x() / MeV);
-    man->FillNtupleDColumn(1, 7, data.momentumBefore.y() / MeV);
-    man->FillNtupleDColumn(1, 8, data.momentumBefore.z() / MeV);
-    man->FillNtupleDColumn(1, 9, data.momentumAfter.x() / MeV);
-    man->FillNtupleDColumn(1, 10, data.momentumAfter.y() / MeV);
-    man->FillNtupleDColumn(1, 11, data.momentumAfter.z() / MeV);
-    man->FillNtupleDColumn(1, 12, data.positionEnter.x() / mm);
-    man->FillNtupleDColumn(1, 13, data.positionEnter.y() / mm);
-    man->FillNtupleDColumn(1, 14, data.positionEnter.z() / mm);
-    man->FillNtupleDColumn(1, 15, data.positionExit.x() / mm);
-    man->FillNtupleDColumn(1, 16, data.positionExit.y() / mm);
-    man->FillNtupleDColumn(1, 17, data.positionExit.z() / mm);
-    man->FillNtupleDColumn(1, 18, rEnter / mm);
-    man->FillNtupleDColumn(1, 19, rExit / mm);
-    man->FillNtupleIColumn(1, 20, data.particleID);
-    man->FillNtupleIColumn(1, 21, data.cumTr);
-    man->FillNtupleDColumn(1, 22, data.charge); 
-    man->FillNtupleDColumn(1, 23, data.etaEnter);
-    man->FillNtupleDColumn(1, 24, data.phiEnter);
-    man->FillNtupleDColumn(1, 25, data.etaExit);
-    man->FillNtupleDColumn(1, 26, data.phiExit);
-    
-    // Commit this row to the ntuple
-    man->AddNtupleRow(1);
+    G4bool newCell = false;
+    MyCellHit& cellData = fCellData.FindOrInsert(detId, newCell);
+    if (newCell) {
+        cellData.detId = detId;
+        cellData.edep = 0.0;
+        cellData.time = time;
+        cellData.z = z;
+    }
+    cellData.edep += edep;
+    cellData.time = std::min(cellData.time, time);
+
+    if (BoundaryTruth::IsEnabled()) {
+        std::uint64_t truthKey = (static_cast<std::uint64_t>(detId) << 32)
+                               | static_cast<std::uint32_t>(boundaryIndex);
+        G4bool newShare = false;
+        MyCellTruthHit& share = fCellTruthData.FindOrInsert(truthKey, newShare);
+        if (newShare) {
+            share.detId = detId;
+            share.boundaryIndex = boundaryIndex;
+            share.edep = 0.0;
+        }
+        share.edep += edep;
+    }
+}
+
+void MySensitiveDetector::StorePremixEvent()
+{
+    fPremixCells.clear();
+    fCellData.ForEach([this](std::uint64_t, const MyCellHit& data) {
+        fPremixCells.push_back({data.detId, static_cast<float>(data.edep / MeV),
+                                static_cast<float>(data.time / ns), static_cast<float>(data.z / mm)});
+    });
+    PremixLibrary::Instance().AddEvent(fPremixCells);
+}
+
+void MySensitiveDetector::OverlayPileup()
+{
+    // Sparse merge: only the cells of the drawn library events are touched.
+    // Their energy has no boundary particle (CellTruth index kPremixIndex).
+    PremixLibrary& library = PremixLibrary::Instance();
+    G4int nPileup = library.DrawPileupCount();
+    for (G4int i = 0; i < nPileup; ++i) {
+        std::size_t nCells = 0;
+        const PremixCell* cells = library.DrawEvent(nCells);
+        for (std::size_t c = 0; c < nCells; ++c) {
+            AddCellDeposit(cells[c].detId, cells[c].edep * MeV, cells[c].time * ns, cells[c].z * mm,
+                           PremixLibrary::kPremixIndex);
+        }
+    }
+}
+
+void MySensitiveDetector::StoreHit(const MyHit& hit)
+{
+    if (hit.totalEnergyDeposited > 10.0 * eV) {
+        fTrackHits->insert(new MyHit(hit));
+    }
 }
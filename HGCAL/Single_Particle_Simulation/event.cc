@@ -0,0 +1,266 @@
+#include "event.hh"
+#include "stacking.hh"
+#include "ShowerLibrary.hh"
+#include "HexCellGeometry.hh"
+#include "G4AnalysisManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4SDManager.hh"
+#include "G4SystemOfUnits.hh"
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+namespace {
+    // One bit per dense detector ID, shared by all threads, so that each cell
+    // appears once in the CellGeometry table of the (merged) output file
+    const std::size_t kExportedWords = (std::size_t(1) << HexCellGeometry::kDenseIndexBits) / 64;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> exportedCells;
+
+    // Returns true for the first caller only
+    G4bool MarkExported(std::uint32_t detId) {
+        std::uint32_t index = HexCellGeometry::DenseIndex(detId);
+        std::atomic<std::uint64_t>& word = exportedCells[index >> 6];
+        std::uint64_t bit = std::uint64_t(1) << (index & 63);
+        if (word.load(std::memory_order_relaxed) & bit) return false;
+        return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+}
+
+MyEventAction::MyEventAction(MyStackingAction* stackingAction)
+: G4UserEventAction(), fStackingAction(stackingAction), fTrackHitsID(-1), fCellHitsID(-1),
+  fCellTruthHitsID(-1)
+{}
+
+MyEventAction::~MyEventAction()
+{}
+
+void MyEventAction::ResetCellGeometry()
+{
+    // Called on the master before the workers start the run
+    if (!exportedCells) {
+        exportedCells.reset(new std::atomic<std::uint64_t>[kExportedWords]());
+    } else {
+        for (std::size_t i = 0; i < kExportedWords; ++i) {
+            exportedCells[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MyEventAction::BeginOfEventAction(const G4Event*)
+{
+    // Collection IDs are fixed once the SD is registered, look them up once
+    if (fTrackHitsID < 0) {
+        G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+        fTrackHitsID = sdManager->GetCollectionID("SensitiveDetector/TrackHits");
+        fCellHitsID = sdManager->GetCollectionID("SensitiveDetector/CellHits");
+        fCellTruthHitsID = sdManager->GetCollectionID("SensitiveDetector/CellTruth");
+    }
+    BoundaryTruth::Instance().Clear();
+}
+
+void MyEventAction::EndOfEventAction(const G4Event* event)
+{
+    if (ShowerLibrary::GetMode() == ShowerLibrary::kGenerate) {
+        ShowerLibraryRecorder::Instance().EndOfEvent();
+    }
+    if (fStackingAction) {
+        fStackingAction->EndOfEvent(event->GetEventID());
+    }
+
+    G4HCofThisEvent* hce = event->GetHCofThisEvent();
+    if (!hce) return;
+
+    G4int eventID = event->GetEventID();
+    auto trackHits = static_cast<MyHitsCollection*>(hce->GetHC(fTrackHitsID));
+    auto cellHits = static_cast<MyCellHitsCollection*>(hce->GetHC(fCellHitsID));
+    auto cellTruthHits = static_cast<MyCellTruthHitsCollection*>(hce->GetHC(fCellTruthHitsID));
+    const std::vector<BoundaryParticle>& boundaryParticles = BoundaryTruth::Instance().GetParticles();
+
+    // Per-layer energy response (LayerEdep histogram)
+    if (trackHits) {
+        G4AnalysisManager* man = G4AnalysisManager::Instance();
+        for (size_t i = 0; i < trackHits->entries(); ++i) {
+            const MyHit& hit = *(*trackHits)[i];
+            man->FillH1(0, hit.layer, hit.totalEnergyDeposited / MeV);
+        }
+    }
+
+    // Asynchronous output: copy the event into a free buffer and go on tracking
+    if (AsyncOutput::Instance().IsOpen()) {
+        // The buffer count may change between runs; the queue was sized for the new one
+        if (!fProducer || fProducer->GetNumberOfBuffers() != AsyncOutput::GetBuffersPerThread()) {
+            fProducer.reset(new AsyncOutputProducer(AsyncOutput::GetBuffersPerThread()));
+        }
+        EventBatch& batch = fProducer->Acquire();
+        batch.eventID = eventID;
+        if (trackHits) {
+            for (size_t i = 0; i < trackHits->entries(); ++i) {
+                batch.trackHits.push_back(*(*trackHits)[i]);
+            }
+        }
+        if (cellHits) {
+            for (size_t i = 0; i < cellHits->entries(); ++i) {
+                const MyCellHit& hit = *(*cellHits)[i];
+                batch.cellHits.push_back(hit);
+                if (exportedCells && MarkExported(hit.detId)) {
+                    batch.newCells.push_back(hit);
+                }
+            }
+        }
+        batch.boundaryParticles = boundaryParticles;
+        if (cellTruthHits) {
+            for (size_t i = 0; i < cellTruthHits->entries(); ++i) {
+                batch.cellTruth.push_back(*(*cellTruthHits)[i]);
+            }
+        }
+        fProducer->Submit();
+        return;
+    }
+
+    if (trackHits) {
+        for (size_t i = 0; i < trackHits->entries(); ++i) {
+            WriteTrackHit(eventID, *(*trackHits)[i]);
+        }
+    }
+
+    if (cellHits) {
+        for (size_t i = 0; i < cellHits->entries(); ++i) {
+            const MyCellHit& hit = *(*cellHits)[i];
+            WriteCellHit(eventID, hit);
+            if (exportedCells && MarkExported(hit.detId)) {
+                WriteCellGeometry(hit);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < boundaryParticles.size(); ++i) {
+        WriteBoundaryParticle(eventID, static_cast<G4int>(i), boundaryParticles[i]);
+    }
+    if (cellTruthHits) {
+        for (size_t i = 0; i < cellTruthHits->entries(); ++i) {
+            WriteCellTruth(eventID, *(*cellTruthHits)[i]);
+        }
+    }
+}
+
+void MyEventAction::WriteTrackHit(G4int eventID, const MyHit& data)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    
+    // Calculate radial distances in x-y plane
+    G4double rEnter = std::sqrt(data.positionEnter.x() * data.positionEnter.x() + 
+                                data.positionEnter.y() * data.positionEnter.y());
+    G4double rExit = std::sqrt(data.positionExit.x() * data.positionExit.x() + 
+                               data.positionExit.y() * data.positionExit.y());
+    
+    // Fill ntuple columns 
+    man->FillNtupleIColumn(1, 0, eventID);
+    man->FillNtupleIColumn(1, 1, data.trackID);
+    man->FillNtupleIColumn(1, 2, data.layer);
+    man->FillNtupleDColumn(1, 3, data.energyBefore / MeV);
+    man->FillNtupleDColumn(1, 4, data.energyAfter / MeV);
+    man->FillNtupleDColumn(1, 5, data.totalEnergyDeposited / MeV);
+    man->FillNtupleDColumn(1, 6, data.momentumBefore.x() / MeV);
+    man->FillNtupleDColumn(1, 7, data.momentumBefore.y() / MeV);
+    man->FillNtupleDColumn(1, 8, data.momentumBefore.z() / MeV);
+    man->FillNtupleDColumn(1, 9, data.momentumAfter.x() / MeV);
+    man->FillNtupleDColumn(1, 10, data.momentumAfter.y() / MeV);
+    man->FillNtupleDColumn(1, 11, data.momentumAfter.z() / MeV);
+    man->FillNtupleDColumn(1, 12, data.positionEnter.x() / mm);
+    man->FillNtupleDColumn(1, 13, data.positionEnter.y() / mm);
+    man->FillNtupleDColumn(1, 14, data.positionEnter.z() / mm);
+    man->FillNtupleDColumn(1, 15, data.positionExit.x() / mm);
+    man->FillNtupleDColumn(1, 16, data.positionExit.y() / mm);
+    man->FillNtupleDColumn(1, 17, data.positionExit.z() / mm);
+    man->FillNtupleDColumn(1, 18, rEnter / mm);
+    man->FillNtupleDColumn(1, 19, rExit / mm);
+    man->FillNtupleIColumn(1, 20, data.particleID);
+    man->FillNtupleIColumn(1, 21, data.cumTr);
+    man->FillNtupleDColumn(1, 22, data.charge); 
+    man->FillNtupleDColumn(1, 23, data.etaEnter);
+    man->FillNtupleDColumn(1, 24, data.phiEnter);
+    man->FillNtupleDColumn(1, 25, data.etaExit);
+    man->FillNtupleDColumn(1, 26, data.phiExit);
+    HexCell entryCell = HexCellGeometry::Locate(data.positionEnter.x(), data.positionEnter.y());
+    man->FillNtupleIColumn(1, 27, static_cast<G4int>(HexCellGeometry::PackDetId(data.layer, entryCell)));
+    
+    // Commit this row to the ntuple
+    man->AddNtupleRow(1);
+}
+
+void MyEventAction::WriteCellHit(G4int eventID, const MyCellHit& data)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    
+    // Compact row: coordinates are recovered from CellGeometry via detid
+    man->FillNtupleIColumn(2, 0, eventID);
+    man->FillNtupleIColumn(2, 1, static_cast<G4int>(data.detId));
+    man->FillNtupleFColumn(2, 2, static_cast<G4float>(data.edep / MeV));
+    man->FillNtupleFColumn(2, 3, static_cast<G4float>(data.time / ns));
+    man->AddNtupleRow(2);
+}
+
+void MyEventAction::WriteCellGeometry(const MyCellHit& data)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    
+    G4int layer;
+    HexCell cell;
+    HexCellGeometry::UnpackDetId(data.detId, layer, cell);
+    
+    // Cell centre at the middle of the silicon layer
+    G4double xi, yi;
+    HexCellGeometry::CellCenter(cell, xi, yi);
+    G4ThreeVector center(xi, yi, data.z);
+    
+    // theta in degrees, phi = atan2(y, x) in degrees within [-180, 180]
+    G4double theta = center.theta();
+    G4double phiDeg = center.phi() / deg;
+    G4double eta = (theta > 0 && theta < CLHEP::pi) ? -std::log(std::tan(theta / 2.0)) : 0.0;
+    
+    man->FillNtupleIColumn(3, 0, static_cast<G4int>(data.detId));
+    man->FillNtupleIColumn(3, 1, layer);
+    man->FillNtupleIColumn(3, 2, cell.waferU);
+    man->FillNtupleIColumn(3, 3, cell.waferV);
+    man->FillNtupleIColumn(3, 4, cell.cellU);
+    man->FillNtupleIColumn(3, 5, cell.cellV);
+    man->FillNtupleIColumn(3, 6, cell.highDensity ? 0 : 1);
+    man->FillNtupleFColumn(3, 7, static_cast<G4float>(xi / mm));
+    man->FillNtupleFColumn(3, 8, static_cast<G4float>(yi / mm));
+    man->FillNtupleFColumn(3, 9, static_cast<G4float>(data.z / mm));
+    man->FillNtupleFColumn(3, 10, static_cast<G4float>(theta / deg));
+    man->FillNtupleFColumn(3, 11, static_cast<G4float>(phiDeg));
+    man->FillNtupleFColumn(3, 12, static_cast<G4float>(eta));
+    man->AddNtupleRow(3);
+}
+
+void MyEventAction::WriteBoundaryParticle(G4int eventID, G4int index, const BoundaryParticle& particle)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    man->FillNtupleIColumn(4, 0, eventID);
+    man->FillNtupleIColumn(4, 1, index);
+    man->FillNtupleIColumn(4, 2, particle.trackID);
+    man->FillNtupleIColumn(4, 3, particle.particleID);
+    man->FillNtupleIColumn(4, 4, particle.cumTr);
+    man->FillNtupleFColumn(4, 5, static_cast<G4float>(particle.energy / MeV));
+    man->FillNtupleFColumn(4, 6, static_cast<G4float>(particle.momentum.x() / MeV));
+    man->FillNtupleFColumn(4, 7, static_cast<G4float>(particle.momentum.y() / MeV));
+    man->FillNtupleFColumn(4, 8, static_cast<G4float>(particle.momentum.z() / MeV));
+    man->FillNtupleFColumn(4, 9, static_cast<G4float>(particle.position.x() / mm));
+    man->FillNtupleFColumn(4, 10, static_cast<G4float>(particle.position.y() / mm));
+    man->FillNtupleFColumn(4, 11, static_cast<G4float>(particle.position.z() / mm));
+    man->FillNtupleFColumn(4, 12, static_cast<G4float>(particle.time / ns));
+    man->AddNtupleRow(4);
+}
+
+void MyEventAction::WriteCellTruth(G4int eventID, const MyCellTruthHit& data)
+{
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+
+    man->FillNtupleIColumn(5, 0, eventID);
+    man->FillNtupleIColumn(5, 1, static_cast<G4int>(data.detId));
+    man->FillNtupleIColumn(5, 2, data.boundaryIndex);
+    man->FillNtupleFColumn(5, 3, static_cast<G4float>(data.fraction));
+    man->AddNtupleRow(5);
+}
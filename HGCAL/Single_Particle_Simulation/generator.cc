@@ -17,7 +17,6 @@
 
 
 
-static G4int cumTrCounter = 0;
 MyPrimaryGenerator::MyPrimaryGenerator()
     : G4VUserPrimaryGeneratorAction(),
       fParticleGun(nullptr)
@@ -60,6 +59,10 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
     G4int nParticlesPerEvent = 1;
     for (int i = 0; i < nParticlesPerEvent; i++) {
 
+        // Cumulative track index, derived from the event ID so that it stays
+        // unique when events are distributed over worker threads
+        G4int cumTr = eventID * nParticlesPerEvent + i;
+
         // ==========================================
         // POSITION: at origin (0, 0, 0)
         // ==========================================
@@ -115,7 +118,7 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
         if (vertex) {
             G4PrimaryParticle* primary = vertex->GetPrimary();
             if (primary) {
-	        primary->SetUserInformation(new PrimaryParticleInformation(eventID));
+	        primary->SetUserInformation(new PrimaryParticleInformation(cumTr));
             }
         }
 
@@ -132,7 +135,7 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
         man->FillNtupleDColumn(0, 7, eta);
         man->FillNtupleDColumn(0, 8, phi);
         man->FillNtupleDColumn(0, 9, theta);
-        man->FillNtupleIColumn(0, 10, cumTrCounter);
+        man->FillNtupleIColumn(0, 10, cumTr);
         man->FillNtupleDColumn(0, 11, pT / MeV);
         man->FillNtupleDColumn(0, 12, charge);
         man->FillNtupleIColumn(0, 13, 0);
@@ -141,9 +144,10 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event* anEvent)
         man->FillNtupleDColumn(0, 16, 0.0);
         man->FillNtupleIColumn(0, 17, static_cast<G4int>(seed));
         man->FillNtupleDColumn(0, 18, static_cast<G4double>(randomNumber));
+        man->FillNtupleIColumn(0, 19, 0);
+        man->FillNtupleDColumn(0, 20, z / mm);
 
         man->AddNtupleRow(0);
-		cumTrCounter++;
 
         G4cout << "  Particle " << i << ": PDG=" << pdgCode << " | pT=" << pT/GeV << " GeV | eta=" << eta
                << " | phi=" << phi << " rad | pTot=" << pTot/GeV << " GeV | charge=" << charge << G4endl;
@@ -0,0 +1,20 @@
+#include "hit.hh"
+
+G4ThreadLocal G4Allocator<MyHit>* MyHitAllocator = nullptr;
+G4ThreadLocal G4Allocator<MyCellHit>* MyCellHitAllocator = nullptr;
+G4ThreadLocal G4Allocator<MyCellTruthHit>* MyCellTruthHitAllocator = nullptr;
+
+MyHit::MyHit()
+: G4VHit(), trackID(0), layer(0), particleID(0), cumTr(-1),
+  charge(0.0), energyBefore(0.0), energyAfter(0.0),
+  totalEnergyDeposited(0.0),
+  etaEnter(0.0), phiEnter(0.0), etaExit(0.0), phiExit(0.0)
+{}
+
+MyCellHit::MyCellHit()
+: G4VHit(), detId(0), edep(0.0), time(0.0), z(0.0)
+{}
+
+MyCellTruthHit::MyCellTruthHit()
+: G4VHit(), detId(0), boundaryIndex(-1), edep(0.0), fraction(0.0)
+{}
@@ -0,0 +1,123 @@
+#ifndef HIT_HH
+#define HIT_HH
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "G4ThreeVector.hh"
+#include <cstdint>
+
+// Energy deposit of one track in one silicon layer (one crossing, one step
+// or one cell, depending on the SD granularity)
+class MyHit : public G4VHit {
+public:
+    MyHit();
+    MyHit(const MyHit&) = default;
+    ~MyHit() override = default;
+    MyHit& operator=(const MyHit&) = default;
+
+    inline void* operator new(size_t);
+    inline void operator delete(void* hit);
+
+    G4int trackID;
+    G4int layer;
+    G4int particleID;
+    G4int cumTr;
+    G4double charge;
+    G4double energyBefore;
+    G4double energyAfter;
+    G4double totalEnergyDeposited;
+    G4ThreeVector momentumBefore;
+    G4ThreeVector momentumAfter;
+    G4ThreeVector positionEnter;
+    G4ThreeVector positionExit;
+    G4double etaEnter;
+    G4double phiEnter;
+    G4double etaExit;
+    G4double phiExit;
+};
+
+// Energy summed in one hexagonal silicon cell over the event
+class MyCellHit : public G4VHit {
+public:
+    MyCellHit();
+    MyCellHit(const MyCellHit&) = default;
+    ~MyCellHit() override = default;
+    MyCellHit& operator=(const MyCellHit&) = default;
+
+    inline void* operator new(size_t);
+    inline void operator delete(void* hit);
+
+    std::uint32_t detId;
+    G4double edep;
+    G4double time;  // earliest deposit
+    G4double z;     // centre of the silicon layer
+};
+
+// Share of one boundary particle (with its descendants) in the energy of one
+// cell over the event (boundary truth, CellTruth ntuple)
+class MyCellTruthHit : public G4VHit {
+public:
+    MyCellTruthHit();
+    MyCellTruthHit(const MyCellTruthHit&) = default;
+    ~MyCellTruthHit() override = default;
+    MyCellTruthHit& operator=(const MyCellTruthHit&) = default;
+
+    inline void* operator new(size_t);
+    inline void operator delete(void* hit);
+
+    std::uint32_t detId;
+    G4int boundaryIndex;  // -1: not attributed to a boundary particle
+    G4double edep;
+    G4double fraction;    // of the cell energy, set at the end of the event
+};
+
+using MyHitsCollection = G4THitsCollection<MyHit>;
+using MyCellHitsCollection = G4THitsCollection<MyCellHit>;
+using MyCellTruthHitsCollection = G4THitsCollection<MyCellTruthHit>;
+
+// Per-thread memory pools
+extern G4ThreadLocal G4Allocator<MyHit>* MyHitAllocator;
+extern G4ThreadLocal G4Allocator<MyCellHit>* MyCellHitAllocator;
+extern G4ThreadLocal G4Allocator<MyCellTruthHit>* MyCellTruthHitAllocator;
+
+inline void* MyHit::operator new(size_t)
+{
+    if (!MyHitAllocator) {
+        MyHitAllocator = new G4Allocator<MyHit>;
+    }
+    return (void*)MyHitAllocator->MallocSingle();
+}
+
+inline void MyHit::operator delete(void* hit)
+{
+    MyHitAllocator->FreeSingle((MyHit*)hit);
+}
+
+inline void* MyCellHit::operator new(size_t)
+{
+    if (!MyCellHitAllocator) {
+        MyCellHitAllocator = new G4Allocator<MyCellHit>;
+    }
+    return (void*)MyCellHitAllocator->MallocSingle();
+}
+
+inline void MyCellHit::operator delete(void* hit)
+{
+    MyCellHitAllocator->FreeSingle((MyCellHit*)hit);
+}
+
+inline void* MyCellTruthHit::operator new(size_t)
+{
+    if (!MyCellTruthHitAllocator) {
+        MyCellTruthHitAllocator = new G4Allocator<MyCellTruthHit>;
+    }
+    return (void*)MyCellTruthHitAllocator->MallocSingle();
+}
+
+inline void MyCellTruthHit::operator delete(void* hit)
+{
+    MyCellTruthHitAllocator->FreeSingle((MyCellTruthHit*)hit);
+}
+
+#endif
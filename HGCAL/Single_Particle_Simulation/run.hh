@@ -3,6 +3,12 @@
 
 #include "G4UserRunAction.hh"
 #include "G4Run.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Accumulable.hh"
+#include "G4Timer.hh"
+#include <vector>
+
+class G4ParticleDefinition;
 
 class MyRunAction : public G4UserRunAction {
 public:
@@ -11,6 +17,98 @@ public:
     
     virtual void BeginOfRunAction(const G4Run*) override;
     virtual void EndOfRunAction(const G4Run*) override;
+
+    void SetAsyncOutput(G4bool enable);
+    void SetAsyncBuffers(G4int nBuffers);
+    void SetBoundaryTruth(G4bool enable);
+    void SetPremixMode(const G4String& mode);
+    void SetPremixFile(const G4String& fileName);
+    void SetPremixMeanPileup(G4double mu);
+    void SetShowerLibraryMode(const G4String& mode);
+    void SetShowerLibraryFile(const G4String& fileName);
+    void SetShowerLibraryMaxPerBin(G4int maxShowers);
+
+    // Tracking cuts (/hgcal/cuts/)
+    G4bool GetKillLoopers() const { return fKillLoopers; }
+    G4bool GetKillNeutrinos() const { return fKillNeutrinos; }
+    G4double GetTimeCut() const { return fTimeCut; }          // <= 0: disabled
+    G4bool GetTimeCutMeasure() const { return fTimeCutMeasure; }
+    void SetTimeCutMode(const G4String& mode) { fTimeCutMode = mode; fTimeCutMeasure = (mode == "measure"); }
+
+    // Current run of this thread. The geometry may be rebuilt between runs,
+    // so dimensions cached from the detector construction compare against it.
+    G4int GetRunID() const { return fRunID; }
+
+    // Stacking (/hgcal/stack/)
+    G4int GetPrimariesPerStage() const { return fPrimariesPerStage; }  // <= 0: all at once
+    G4bool GetStackVerbose() const { return fStackVerbose; }
+
+    // Species of the time-cut statistics
+    enum LateSpecies { kLateNeutron, kLateGamma, kLateElectron, kLateProton, kLateNucleus, kLateOther,
+                       kNumLateSpecies };
+    static G4int GetLateSpecies(const G4ParticleDefinition* particle);
+
+    // Counters, merged over worker threads at the end of the run
+    void CountStep() { fSteps += 1.; }
+    void CountGenerated(G4int n) { fGenerated += n; }
+    void CountFilteredEta() { fFilteredEta += 1; }
+    void CountFilteredPt() { fFilteredPt += 1; }
+    void CountDropped() { fDropped += 1; }
+    void CountLooperKilled(G4double energy) { fLoopersKilled += 1; fKilledEnergy += energy; }
+    void CountBackwardKilled(G4double energy) { fBackwardKilled += 1; fKilledEnergy += energy; }
+    void CountNeutrinoKilled(G4double energy) { fNeutrinosKilled += 1; fNeutrinoEnergy += energy; }
+    void CountEventStack(G4int peakStackSize, G4double residentMB) {
+        fStackEvents += 1;
+        fPeakStackSum += peakStackSize;
+        fResidentSum += residentMB;
+    }
+    // Tracks past the time cut (killed, or in measure mode seen crossing it),
+    // and in measure mode the steps and CPU time they cost beyond it
+    void CountLateTrack(G4int species, G4double energy) { fLateTracks[species] += 1; fLateEnergy[species] += energy; }
+    void CountLateStep(G4int species, G4double seconds) { fLateSteps[species] += 1.; fLateSeconds[species] += seconds; }
+
+private:
+    G4GenericMessenger* fMessenger;
+    G4GenericMessenger* fCutsMessenger;
+    G4GenericMessenger* fLibraryMessenger;
+    G4GenericMessenger* fStackMessenger;
+    G4GenericMessenger* fPremixMessenger;
+
+    G4int fRunID;
+
+    G4bool fKillLoopers;
+    G4double fTimeCut;
+    G4String fTimeCutMode;
+    G4bool fTimeCutMeasure;
+    G4bool fKillNeutrinos;
+    G4int fPrimariesPerStage;
+    G4bool fStackVerbose;
+
+    // Wall-clock time of the event loop (master)
+    G4Timer fTimer;
+
+    G4Accumulable<G4double> fSteps;        // all steps (navigation throughput)
+    G4Accumulable<G4int> fGenerated;       // primaries read from the input
+    G4Accumulable<G4int> fFilteredEta;     // outside the eta window
+    G4Accumulable<G4int> fFilteredPt;      // below pT threshold or helix inside the bore
+    G4Accumulable<G4int> fDropped;         // dropped by the front-face propagation
+    G4Accumulable<G4int> fLoopersKilled;   // killed in vacuum: curling inside the bore
+    G4Accumulable<G4int> fBackwardKilled;  // killed in vacuum: pz <= 0
+    G4Accumulable<G4double> fKilledEnergy; // kinetic energy of killed tracks
+    G4Accumulable<G4int> fNeutrinosKilled;
+    G4Accumulable<G4double> fNeutrinoEnergy;
+    G4Accumulable<G4int> fStackEvents;     // events reported by the stacking action
+    G4Accumulable<G4double> fPeakStackSum; // sum over events of the peak stack size
+    G4Accumulable<G4double> fResidentSum;  // sum over events of the resident memory [MB]
+
+    // Per LateSpecies; sized once, the manager keeps pointers to the elements
+    std::vector<G4Accumulable<G4int>> fLateTracks;
+    std::vector<G4Accumulable<G4double>> fLateEnergy;
+    std::vector<G4Accumulable<G4double>> fLateSteps;
+    std::vector<G4Accumulable<G4double>> fLateSeconds;
+
+    void PrintCounters(const G4Run* run) const;
+    void PrintLayerResponse(const G4Run* run) const;
 };
 
 #endif
@@ -0,0 +1,114 @@
+#include "stacking.hh"
+#include "run.hh"
+#include "construction.hh"
+#include "G4Track.hh"
+#include "G4StackManager.hh"
+#include "G4RunManager.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+    // Resident set size of the process in MB (all threads), 0 if unknown
+    G4double ResidentMemoryMB() {
+        std::ifstream statm("/proc/self/statm");
+        long totalPages = 0, residentPages = 0;
+        if (!(statm >> totalPages >> residentPages)) return 0.;
+        return residentPages * static_cast<G4double>(sysconf(_SC_PAGESIZE)) / (1024. * 1024.);
+    }
+}
+
+MyStackingAction::MyStackingAction(MyRunAction* runAction)
+: G4UserStackingAction(), fRunAction(runAction), fActivePrimaries(0), fPeakStackSize(0),
+  fGeometryRunID(-1), fFrontFaceZ(0.)
+{}
+
+MyStackingAction::~MyStackingAction()
+{}
+
+G4ClassificationOfNewTrack MyStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    G4ClassificationOfNewTrack classification = Classify(track);
+    if (classification != fKill) {
+        // Count each stack explicitly, so primaries parked in the postpone
+        // stack are part of the peak
+        G4int stacked = stackManager->GetNUrgentTrack() + stackManager->GetNWaitingTrack()
+                      + stackManager->GetNPostponedTrack();
+        fPeakStackSize = std::max(fPeakStackSize, stacked + 1);
+    }
+    return classification;
+}
+
+G4ClassificationOfNewTrack MyStackingAction::Classify(const G4Track* track)
+{
+    // In measure mode late tracks are kept and accounted for in the stepping action
+    G4double timeCut = fRunAction->GetTimeCut();
+    if (timeCut > 0. && !fRunAction->GetTimeCutMeasure() && track->GetGlobalTime() > timeCut) {
+        fRunAction->CountLateTrack(MyRunAction::GetLateSpecies(track->GetDefinition()),
+                                   track->GetKineticEnergy());
+        return fKill;
+    }
+
+    // No deposition potential: neutrinos, and tracks in front of the
+    // calorimeter moving away from it (pz is conserved in the vacuum)
+    if (fRunAction->GetKillNeutrinos()) {
+        G4int pdg = std::abs(track->GetDefinition()->GetPDGEncoding());
+        if (pdg == 12 || pdg == 14 || pdg == 16) {
+            fRunAction->CountNeutrinoKilled(track->GetKineticEnergy());
+            return fKill;
+        }
+    }
+    if (fRunAction->GetKillLoopers()) {
+        if (fGeometryRunID != fRunAction->GetRunID()) {
+            const MyDetectorConstruction* detector = static_cast<const MyDetectorConstruction*>(
+                G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+            fFrontFaceZ = detector->GetFrontFaceZ();
+            fGeometryRunID = fRunAction->GetRunID();
+        }
+        if (track->GetPosition().z() < fFrontFaceZ && track->GetMomentumDirection().z() <= 0.) {
+            fRunAction->CountBackwardKilled(track->GetKineticEnergy());
+            return fKill;
+        }
+    }
+
+    // Primaries beyond the first stage's quota are parked in the postpone
+    // stack and released by NewStage; everything else is urgent
+    G4int primariesPerStage = fRunAction->GetPrimariesPerStage();
+    if (primariesPerStage > 0 && track->GetParentID() == 0) {
+        if (fActivePrimaries >= primariesPerStage) return fPostpone;
+        ++fActivePrimaries;
+    }
+    return fUrgent;
+}
+
+void MyStackingAction::NewStage()
+{
+    // The urgent stack is empty: move the next few parked primaries into it.
+    // One transfer per released track, so the cost does not grow with the
+    // number still parked (ReClassify would revisit all of them every stage).
+    G4int primariesPerStage = fRunAction->GetPrimariesPerStage();
+    if (primariesPerStage <= 0) return;
+    for (G4int i = 0; i < primariesPerStage && stackManager->GetNPostponedTrack() > 0; ++i) {
+        stackManager->TransferOneStackedTrack(fPostpone, fUrgent);
+    }
+}
+
+void MyStackingAction::PrepareNewEvent()
+{
+    // Primaries of an aborted event must not leak into this one
+    stackManager->ClearPostponeStack();
+    fActivePrimaries = 0;
+    fPeakStackSize = 0;
+}
+
+void MyStackingAction::EndOfEvent(G4int eventID)
+{
+    G4double residentMB = ResidentMemoryMB();
+    fRunAction->CountEventStack(fPeakStackSize, residentMB);
+    if (fRunAction->GetStackVerbose()) {
+        G4cout << "Event " << eventID << ": peak stack " << fPeakStackSize
+               << " tracks, resident memory " << residentMB << " MB" << G4endl;
+    }
+}
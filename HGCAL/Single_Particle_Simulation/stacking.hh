@@ -0,0 +1,46 @@
+#ifndef STACKING_HH
+#define STACKING_HH
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class MyRunAction;
+
+// Classifies new tracks:
+// - kills tracks past the global time cut (neutron captures, delayed
+//   decays), neutrinos, and tracks upstream of the calorimeter moving away
+// - keeps the stack bounded in events with many primaries: only
+//   /hgcal/stack/primariesPerStage primaries are urgent at a time, the others
+//   are parked in the postpone stack and released a batch per stage;
+//   secondaries are always urgent, so each batch's showers are tracked
+//   depth-first before the next batch starts
+// At the end of each event MyEventAction calls EndOfEvent, which reports the
+// peak stack size and the resident memory of the process.
+class MyStackingAction : public G4UserStackingAction {
+public:
+    MyStackingAction(MyRunAction* runAction);
+    virtual ~MyStackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+    virtual void NewStage() override;
+    virtual void PrepareNewEvent() override;
+
+    // Most tracks held by the stacks at once in the current event
+    // (urgent, waiting, and primaries parked in the postpone stack)
+    G4int GetPeakStackSize() const { return fPeakStackSize; }
+    void EndOfEvent(G4int eventID);
+
+private:
+    MyRunAction* fRunAction;
+
+    G4int fActivePrimaries;  // primaries made urgent in the first stage
+    G4int fPeakStackSize;
+
+    // Front face of the stack, cached from the detector construction each run
+    G4int fGeometryRunID;
+    G4double fFrontFaceZ;
+
+    G4ClassificationOfNewTrack Classify(const G4Track* track);
+};
+
+#endif
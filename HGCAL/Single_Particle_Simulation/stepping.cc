@@ -0,0 +1,128 @@
+#include "stepping.hh"
+#include "run.hh"
+#include "construction.hh"
+#include "BoundaryTruth.hh"
+#include "TrackInformation.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4VTouchable.hh"
+#include "G4RunManager.hh"
+#include "CLHEP/Units/PhysicalConstants.h"
+#include <cmath>
+
+MySteppingAction::MySteppingAction(MyRunAction* runAction)
+: G4UserSteppingAction(), fRunAction(runAction), fGeometryRunID(-1),
+  fFrontFaceZ(0.), fMinInnerRadius(0.), fFieldZ(0.)
+{}
+
+MySteppingAction::~MySteppingAction()
+{}
+
+void MySteppingAction::CacheGeometry()
+{
+    const MyDetectorConstruction* detector = static_cast<const MyDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    fFrontFaceZ = detector->GetFrontFaceZ();
+    fMinInnerRadius = detector->GetMinInnerRadius();
+    fFieldZ = detector->GetFieldZ();
+    fGeometryRunID = fRunAction->GetRunID();
+}
+
+G4bool MySteppingAction::ApplyTimeCut(const G4Step* step, G4double timeCut)
+{
+    G4Track* track = step->GetTrack();
+    G4double preTime = step->GetPreStepPoint()->GetGlobalTime();
+    G4double postTime = step->GetPostStepPoint()->GetGlobalTime();
+
+    if (!fRunAction->GetTimeCutMeasure()) {
+        if (postTime <= timeCut) return false;
+        track->SetTrackStatus(fStopAndKill);
+        fRunAction->CountLateTrack(MyRunAction::GetLateSpecies(track->GetDefinition()),
+                                   track->GetKineticEnergy());
+        return true;
+    }
+
+    // Measure mode: the time since the previous step of the same track is
+    // the cost of this step (nothing is known for the first one)
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    G4int stepNumber = track->GetCurrentStepNumber();
+    if (postTime > timeCut) {
+        G4int species = MyRunAction::GetLateSpecies(track->GetDefinition());
+        if (preTime <= timeCut || stepNumber == 1) {
+            fRunAction->CountLateTrack(species, step->GetPreStepPoint()->GetKineticEnergy());
+        }
+        G4double seconds = 0.;
+        if (stepNumber > 1) {
+            seconds = std::chrono::duration<G4double>(now - fLastStepClock).count();
+        }
+        fRunAction->CountLateStep(species, seconds);
+    }
+    fLastStepClock = now;
+    return false;
+}
+
+void MySteppingAction::RecordBoundaryCrossing(const G4Step* step)
+{
+    // From the world into a daughter volume (a layer, or the endcap envelope)
+    const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+    if (postStepPoint->GetStepStatus() != fGeomBoundary) return;
+    if (step->GetPreStepPoint()->GetTouchable()->GetHistoryDepth() != 0) return;
+    if (!postStepPoint->GetPhysicalVolume() || postStepPoint->GetTouchable()->GetHistoryDepth() == 0) return;
+
+    // Descendants of a particle that entered before keep its index
+    G4Track* track = step->GetTrack();
+    if (TrackInformation::BoundaryIndexOf(track) >= 0) return;
+
+    G4int index = BoundaryTruth::Instance().Add(track, postStepPoint);
+    TrackInformation* info = static_cast<TrackInformation*>(track->GetUserInformation());
+    if (info) {
+        info->SetBoundaryIndex(index);
+    } else {
+        track->SetUserInformation(new TrackInformation(-1, index));
+    }
+}
+
+void MySteppingAction::UserSteppingAction(const G4Step* step)
+{
+    fRunAction->CountStep();
+
+    G4double timeCut = fRunAction->GetTimeCut();
+    if (timeCut > 0. && ApplyTimeCut(step, timeCut)) return;
+
+    if (BoundaryTruth::IsEnabled()) RecordBoundaryCrossing(step);
+
+    if (!fRunAction->GetKillLoopers()) return;
+
+    // Only steps in the world volume (vacuum), upstream of the first layer
+    if (step->GetPreStepPoint()->GetTouchable()->GetHistoryDepth() != 0) return;
+
+    G4Track* track = step->GetTrack();
+    if (track->GetTrackStatus() != fAlive) return;
+
+    if (fGeometryRunID != fRunAction->GetRunID()) CacheGeometry();
+
+    const G4ThreeVector& position = track->GetPosition();
+    if (position.z() >= fFrontFaceZ) return;
+
+    // pz is conserved in vacuum: a backward-moving track never gets there
+    const G4ThreeVector& momentum = track->GetMomentum();
+    if (momentum.z() <= 0.) {
+        track->SetTrackStatus(fStopAndKill);
+        fRunAction->CountBackwardKilled(track->GetKineticEnergy());
+        return;
+    }
+
+    // Charged: helix centre (xc, yc) and radius R; the largest distance from
+    // the beam line it can reach is |c| + R
+    G4double charge = track->GetDefinition()->GetPDGCharge();
+    if (charge == 0.) return;
+    G4double k = -charge * fFieldZ * CLHEP::c_light;
+    G4double xc = position.x() - momentum.y() / k;
+    G4double yc = position.y() + momentum.x() / k;
+    G4double radius = momentum.perp() / std::fabs(k);
+    if (std::hypot(xc, yc) + radius < fMinInnerRadius) {
+        track->SetTrackStatus(fStopAndKill);
+        fRunAction->CountLooperKilled(track->GetKineticEnergy());
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef STEPPING_HH
+#define STEPPING_HH
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+#include <chrono>
+
+class MyRunAction;
+
+// Time cut: kills tracks once their global time passes /hgcal/cuts/timeCut,
+// or in measure mode keeps them and times every step beyond it.
+// Looper killer: in the vacuum in front of the calorimeter, kills tracks
+// that can never reach it (moving backwards, or curling in the field on a
+// helix that stays inside the innermost bore)
+// Boundary truth: records particles entering the calorimeter (BoundaryTruth)
+class MySteppingAction : public G4UserSteppingAction {
+public:
+    MySteppingAction(MyRunAction* runAction);
+    virtual ~MySteppingAction();
+
+    virtual void UserSteppingAction(const G4Step* step) override;
+
+private:
+    MyRunAction* fRunAction;
+
+    // Stack envelope and field, re-read from the detector construction each run
+    G4int fGeometryRunID;  // run the values below were read in
+    G4double fFrontFaceZ;
+    G4double fMinInnerRadius;
+    G4double fFieldZ;
+
+    // Measure mode: wall clock of the previous step of this thread
+    std::chrono::steady_clock::time_point fLastStepClock;
+
+    void CacheGeometry();
+    // True if the track was killed
+    G4bool ApplyTimeCut(const G4Step* step, G4double timeCut);
+    void RecordBoundaryCrossing(const G4Step* step);
+};
+
+#endif